@@ -0,0 +1,466 @@
+/*******************************************************************************
+   Filename: benchmark.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definitions of headless benchmarks used to measure the cost of
+             core data structures (no window or GL context is required).
+*******************************************************************************/
+
+#include "benchmark.h"
+
+const int NUM_POSITION_QUERIES = 10000000;
+const int NUM_PATH_QUERIES = 200;
+const int NUM_WALL_CHANGES = 1000;
+const int NEARBY_QUERY_RADIUS = 64;  // cells, for queries between nearby NPCs
+
+// Replica of the original per-cell layout (six walls, six neighbor pointers
+// and six texture numbers per heap-allocated cell), kept only for comparison.
+struct LegacyCell {
+  bool walls[NUM_SIDES],
+       visited;
+  LegacyCell *neighbors[NUM_SIDES];
+  int textures[NUM_SIDES];
+};
+
+//------------------------------------------------------------------------------
+//      Method: secondsSince
+//
+// Description: Returns the time elapsed since a given point in time.
+//
+//      Inputs: start - The point in time of interest.
+//
+//     Outputs: Elapsed time, in seconds.
+//------------------------------------------------------------------------------
+static double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+//      Method: buildLegacyCells
+//
+// Description: Allocates one LegacyCell per quest cell, wires up neighbor
+//              pointers, and copies the quest's walls and textures, exactly as
+//              the original 'Quest::initializeCells' and 'assignNeighbors'
+//              did.
+//
+//      Inputs: quest - The quest whose maze is to be copied.
+//
+//     Outputs: A vector of newly allocated LegacyCell pointers (row-major).
+//------------------------------------------------------------------------------
+static vector<LegacyCell *> buildLegacyCells(const Quest &quest) {
+  int width = quest.getWidth(), height = quest.getHeight();
+  vector<LegacyCell *> cells;
+
+  cells.reserve(width * height);
+  for (int i = 0; i < width * height; ++i) {
+    LegacyCell *cell = new LegacyCell;
+    for (int side = 0; side < NUM_SIDES; ++side) {
+      cell->walls[side] = quest.getCell(i).hasWallAt(side);
+      cell->neighbors[side] = NULL;
+      cell->textures[side] = quest.getMaterial(WALL_MATERIAL);
+    }
+    cell->visited = false;
+    cells.push_back(cell);
+  }
+  for (int i = 0; i < width * height; ++i) {
+    for (int side = 0; side < 4; ++side) {
+      int neighbor = quest.getNeighborIndex(i, side);
+      if (neighbor >= 0) {
+        cells[i]->neighbors[side] = cells[neighbor];
+      }
+    }
+  }
+
+  return cells;
+}
+
+//------------------------------------------------------------------------------
+//      Method: floodLegacy
+//
+// Description: Visits every cell reachable from a given cell by following
+//              neighbor pointers through open walls.
+//
+//      Inputs: start - The cell from which the flood begins.
+//              n     - Total number of cells (for sizing the work queue).
+//
+//     Outputs: The number of cells reached.
+//------------------------------------------------------------------------------
+static int floodLegacy(LegacyCell *start, int n) {
+  vector<LegacyCell *> queue;
+  int nReached = 0;
+
+  queue.reserve(n);
+  queue.push_back(start);
+  start->visited = true;
+  for (size_t next = 0; next < queue.size(); ++next) {
+    LegacyCell *cell = queue[next];
+    ++nReached;
+    for (int side = 0; side < 4; ++side) {
+      LegacyCell *neighbor = cell->neighbors[side];
+      if (!cell->walls[side] && neighbor && !neighbor->visited) {
+        neighbor->visited = true;
+        queue.push_back(neighbor);
+      }
+    }
+  }
+
+  return nReached;
+}
+
+//------------------------------------------------------------------------------
+//      Method: floodGrid
+//
+// Description: Visits every cell reachable from a given cell of the quest's
+//              contiguous grid by following open walls. Outer walls are never
+//              removed, so an open wall always leads to the neighbor at a
+//              fixed index offset and no bounds checks are needed.
+//
+//      Inputs: quest - The quest of interest.
+//              start - Index of the cell from which the flood begins.
+//
+//     Outputs: The number of cells reached.
+//------------------------------------------------------------------------------
+static int floodGrid(const Quest &quest, int start) {
+  int width = quest.getWidth(), n = width * quest.getHeight();
+  int offsets[4];
+  vector<unsigned char> reached(n, 0);
+  vector<int> queue;
+
+  offsets[NORTH] = width;
+  offsets[SOUTH] = -width;
+  offsets[EAST] = 1;
+  offsets[WEST] = -1;
+  queue.reserve(n);
+  queue.push_back(start);
+  reached[start] = 1;
+  for (size_t next = 0; next < queue.size(); ++next) {
+    int cellIndex = queue[next];
+    unsigned char walls = quest.getCell(cellIndex).getWalls();
+    for (int side = 0; side < 4; ++side) {
+      int neighbor = cellIndex + offsets[side];
+      if (!(walls & (1 << side)) && !reached[neighbor]) {
+        reached[neighbor] = 1;
+        queue.push_back(neighbor);
+      }
+    }
+  }
+
+  return queue.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: isLegalLegacyPosition
+//
+// Description: Equivalent of 'Quest::isLegalPosition' over the legacy layout.
+//
+//      Inputs: cells         - The legacy cells (row-major).
+//              width, height - Maze dimensions, measured in cells.
+//              x, y          - Coordinates of the position to be tested.
+//              radius        - Collision radius.
+//
+//     Outputs: Returns 'true' if the position is legal, 'false' otherwise.
+//------------------------------------------------------------------------------
+static bool isLegalLegacyPosition(const vector<LegacyCell *> &cells,
+                                  int width, int height,
+                                  double x, double y, double radius) {
+  if (y < 0 || y >= height || x < 0 || x >= width) {
+    return false;
+  }
+
+  const LegacyCell *cell = cells[(int) x + ((int) y) * width];
+  double offsetX = x - (int) x;
+  double offsetY = y - (int) y;
+
+  return !(cell->walls[NORTH] && offsetY + radius > 1.0) &&
+         !(cell->walls[SOUTH] && offsetY - radius < 0.0) &&
+         !(cell->walls[EAST] && offsetX + radius > 1.0) &&
+         !(cell->walls[WEST] && offsetX - radius < 0.0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: runGridBenchmark
+//
+// Description: Generates a quest of a given size, then compares its contiguous
+//              wall-bitmask grid against the original pointer-linked cell
+//              layout in terms of memory footprint, full-maze flood fill time,
+//              and random collision query time. Results are printed to
+//              standard output.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//
+//     Outputs: 0 if successful, 1 if the dimensions are invalid.
+//------------------------------------------------------------------------------
+int runGridBenchmark(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    cerr << "Error: invalid maze size " << width << "x" << height << "."
+         << endl;
+    return 1;
+  }
+
+  Quest quest(DEFAULT_QUEST_NO, width, height);
+  vector<LegacyCell *> legacyCells = buildLegacyCells(quest);
+  int n = width * height;
+  int start = quest.getStartX();
+  chrono::steady_clock::time_point startTime;
+
+  cout << "Grid benchmark: " << width << "x" << height << " (" << n
+       << " cells)" << endl;
+  cout << "  memory  legacy: " << n * (sizeof(LegacyCell) + sizeof(void *))
+       << " bytes (" << sizeof(LegacyCell) << " per cell + pointer, "
+       << "one heap block each)" << endl;
+  cout << "          grid:   " << n * sizeof(Cell) << " bytes ("
+       << sizeof(Cell) << " per cell, contiguous)" << endl;
+
+  startTime = chrono::steady_clock::now();
+  int nReached = floodLegacy(legacyCells[start], n);
+  double legacyFlood = secondsSince(startTime);
+  startTime = chrono::steady_clock::now();
+  int nGridReached = floodGrid(quest, start);
+  double gridFlood = secondsSince(startTime);
+  cout << "  flood   legacy: " << legacyFlood * 1000.0 << " ms, grid: "
+       << gridFlood * 1000.0 << " ms (" << nReached << "/" << nGridReached
+       << " cells reached)" << endl;
+
+  vector<double> positions(2 * NUM_POSITION_QUERIES);
+  Random random;
+  for (int i = 0; i < NUM_POSITION_QUERIES; ++i) {
+    positions[2 * i] = random.nextDouble() * width;
+    positions[2 * i + 1] = random.nextDouble() * height;
+  }
+  int nLegal = 0;
+  startTime = chrono::steady_clock::now();
+  for (int i = 0; i < NUM_POSITION_QUERIES; ++i) {
+    nLegal += isLegalLegacyPosition(legacyCells, width, height,
+                                    positions[2 * i], positions[2 * i + 1],
+                                    0.25);
+  }
+  double legacyQueries = secondsSince(startTime);
+  int nGridLegal = 0;
+  startTime = chrono::steady_clock::now();
+  for (int i = 0; i < NUM_POSITION_QUERIES; ++i) {
+    nGridLegal += quest.isLegalPosition(positions[2 * i],
+                                        positions[2 * i + 1], 0.25);
+  }
+  double gridQueries = secondsSince(startTime);
+  cout << "  queries legacy: " << legacyQueries * 1000.0 << " ms, grid: "
+       << gridQueries * 1000.0 << " ms (" << NUM_POSITION_QUERIES
+       << " isLegalPosition calls, " << nLegal << "/" << nGridLegal
+       << " legal)" << endl;
+
+  for (int i = 0; i < n; ++i) {
+    delete legacyCells[i];
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: searchGrid
+//
+// Description: A static helper that finds the length of a shortest path between
+//              two cells by breadth-first search over the whole grid, as a
+//              reference for the pathfinder.
+//
+//      Inputs: quest    - The quest whose maze is to be searched.
+//              from, to - Indices of the start and goal cells.
+//              queue    - Scratch storage (resized as needed).
+//              steps    - Scratch storage (resized as needed).
+//
+//     Outputs: The number of steps along a shortest path, or -1 if the goal
+//              cannot be reached.
+//------------------------------------------------------------------------------
+static int searchGrid(const Quest &quest, int from, int to, vector<int> &queue,
+                      vector<int> &steps) {
+  int n = quest.getWidth() * quest.getHeight();
+
+  steps.assign(n, -1);
+  queue.resize(n);
+  steps[from] = 0;
+  queue[0] = from;
+  for (int head = 0, tail = 1; head < tail && steps[to] < 0; ++head) {
+    int cellIndex = queue[head];
+    for (int side = NORTH; side <= WEST; ++side) {
+      int neighbor = quest.getNeighborIndex(cellIndex, side);
+      if (neighbor >= 0 && steps[neighbor] < 0 &&
+          !quest.getCell(cellIndex).hasWallAt(side)) {
+        steps[neighbor] = steps[cellIndex] + 1;
+        queue[tail++] = neighbor;
+      }
+    }
+  }
+
+  return steps[to];
+}
+
+//------------------------------------------------------------------------------
+//      Method: isValidPath
+//
+// Description: A static helper that determines whether a path returned by the
+//              pathfinder connects the expected cells through open walls only.
+//
+//      Inputs: quest    - The quest whose maze was searched.
+//              path     - Indices of the cells along the path.
+//              from, to - Indices of the expected start and goal cells.
+//
+//     Outputs: Returns 'true' if the path is valid, 'false' otherwise.
+//------------------------------------------------------------------------------
+static bool isValidPath(const Quest &quest, const vector<int> &path, int from,
+                        int to) {
+  if (path.empty() || path.front() != from || path.back() != to) {
+    return false;
+  }
+  for (size_t i = 1; i < path.size(); ++i) {
+    bool isStep = false;
+    for (int side = NORTH; side <= WEST; ++side) {
+      if (quest.getNeighborIndex(path[i - 1], side) == path[i] &&
+          !quest.getCell(path[i - 1]).hasWallAt(side)) {
+        isStep = true;
+      }
+    }
+    if (!isStep) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: comparePathQueries
+//
+// Description: A static helper that runs random path queries with both the
+//              pathfinder and a whole-grid breadth-first search, reporting the
+//              time per query of each and any disagreement. The path returned
+//              for every query is also checked: it must be as long as
+//              reported and lead from start to goal through open sides.
+//
+//      Inputs: quest           - The quest whose maze is to be searched.
+//              random          - Stream used to pick the queries' cells.
+//              radius          - Maximum distance (along each axis) between
+//                                each query's cells, or 0 for no limit.
+//              isWithinCluster - Whether each query's goal is to be picked
+//                                from the start's cluster (of the default
+//                                size; see 'Pathfinder').
+//
+//     Outputs: The number of queries whose results disagree.
+//------------------------------------------------------------------------------
+static int comparePathQueries(Quest &quest, Random &random, int radius,
+                              bool isWithinCluster) {
+  int n = quest.getWidth() * quest.getHeight(),
+      nMismatches = 0;
+  vector<int> from(NUM_PATH_QUERIES),
+              to(NUM_PATH_QUERIES),
+              lengths(NUM_PATH_QUERIES),
+              queue,
+              steps,
+              path;
+  chrono::steady_clock::time_point startTime;
+  long long totalLength = 0;
+
+  int width = quest.getWidth(),
+      height = quest.getHeight();
+  for (int i = 0; i < NUM_PATH_QUERIES; ++i) {
+    from[i] = random.nextInt(n);
+    to[i] = random.nextInt(n);
+    if (radius > 0) {
+      int x = from[i] % width + random.nextInt(2 * radius + 1) - radius,
+          y = from[i] / width + random.nextInt(2 * radius + 1) - radius;
+      to[i] = min(max(x, 0), width - 1) + min(max(y, 0), height - 1) * width;
+    }
+    if (isWithinCluster) {
+      int minX = from[i] % width / DEFAULT_CLUSTER_SIZE * DEFAULT_CLUSTER_SIZE,
+          minY = from[i] / width / DEFAULT_CLUSTER_SIZE * DEFAULT_CLUSTER_SIZE;
+      to[i] = minX + random.nextInt(min(DEFAULT_CLUSTER_SIZE, width - minX)) +
+              (minY + random.nextInt(min(DEFAULT_CLUSTER_SIZE,
+                                         height - minY))) * width;
+    }
+  }
+  Pathfinder *pathfinder = quest.getPathfinder();
+  startTime = chrono::steady_clock::now();
+  for (int i = 0; i < NUM_PATH_QUERIES; ++i) {
+    lengths[i] = pathfinder->findPath(from[i] % width, from[i] / width,
+                                      to[i] % width, to[i] / width);
+  }
+  double pathfinderQueries = secondsSince(startTime);
+  startTime = chrono::steady_clock::now();
+  for (int i = 0; i < NUM_PATH_QUERIES; ++i) {
+    int length = searchGrid(quest, from[i], to[i], queue, steps);
+    totalLength += max(0, length);
+    nMismatches += (length != lengths[i]);
+  }
+  double gridQueries = secondsSince(startTime);
+  for (int i = 0; i < NUM_PATH_QUERIES; ++i) {
+    int length = pathfinder->findPath(from[i] % width, from[i] / width,
+                                      to[i] % width, to[i] / width, &path);
+    if (length >= 0 && (path.size() != length + 1 ||
+                        !isValidPath(quest, path, from[i], to[i]))) {
+      ++nMismatches;
+    }
+  }
+  cout << (isWithinCluster ? "  cluster" :
+           (radius > 0 ? "  nearby " : "  queries")) << " pathfinder: "
+       << pathfinderQueries * 1e6 / NUM_PATH_QUERIES << " us, grid search: "
+       << gridQueries * 1e6 / NUM_PATH_QUERIES << " us per query (mean "
+       << totalLength / NUM_PATH_QUERIES << " steps, " << nMismatches
+       << " mismatches)" << endl;
+
+  return nMismatches;
+}
+
+//------------------------------------------------------------------------------
+//      Method: runPathBenchmark
+//
+// Description: Measures the quest pathfinder: preprocessing time, the time per
+//              long-range query compared with a whole-grid breadth-first search
+//              (checking that both agree), and the time to update the
+//              hierarchy after walls change. Walls are both removed (creating
+//              loops) and added (possibly disconnecting regions), after which
+//              the queries are checked again; then more walls are removed, and
+//              queries between cells of the same cluster are checked.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//
+//     Outputs: 0 if successful, 1 if the dimensions are invalid or any query
+//              result was wrong.
+//------------------------------------------------------------------------------
+int runPathBenchmark(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    cerr << "Error: invalid maze size " << width << "x" << height << "."
+         << endl;
+    return 1;
+  }
+
+  Quest quest(DEFAULT_QUEST_NO, width, height);
+  Pathfinder *pathfinder = quest.getPathfinder();
+  Random random;
+  cout << "Path benchmark: " << width << "x" << height << " ("
+       << width * height << " cells)" << endl;
+  cout << "  build   " << pathfinder->getBuildTime() * 1000.0 << " ms ("
+       << pathfinder->getNumClusters() << " clusters, "
+       << pathfinder->getNumJunctions() << " junction-graph nodes, "
+       << pathfinder->getNumNodes() << " entrances)" << endl;
+  int nMismatches = comparePathQueries(quest, random, 0, false) +
+                    comparePathQueries(quest, random, NEARBY_QUERY_RADIUS,
+                                       false);
+
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  for (int i = 0; i < NUM_WALL_CHANGES; ++i) {
+    quest.setWall(random.nextInt(width), random.nextInt(height),
+                  random.nextInt(4), i % 2 == 1);
+  }
+  cout << "  update  " << secondsSince(startTime) * 1e6 / NUM_WALL_CHANGES
+       << " us per wall change (" << NUM_WALL_CHANGES << " changes)" << endl;
+  nMismatches += comparePathQueries(quest, random, 0, false) +
+                 comparePathQueries(quest, random, NEARBY_QUERY_RADIUS, false);
+
+  // removed walls alone leave loops, so that a shortest path between two
+  // cells of one cluster often leaves it
+  for (int i = 0; i < NUM_WALL_CHANGES; ++i) {
+    quest.setWall(random.nextInt(width), random.nextInt(height),
+                  random.nextInt(4), false);
+  }
+  nMismatches += comparePathQueries(quest, random, 0, true);
+
+  return nMismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+/*******************************************************************************
+   Filename: benchmark.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declarations of headless benchmarks used to measure the cost of
+             core data structures (no window or GL context is required).
+*******************************************************************************/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "quest.h"
+
+int runGridBenchmark(int width, int height);
+int runPathBenchmark(int width, int height);
+
+#endif  // BENCHMARK_H_
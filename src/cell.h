@@ -4,7 +4,9 @@
      Author: David C. Drake (https://davidcdrake.com)
 
 Description: Declaration of a 'Cell' class, corresponding to a single cube of
-             space within a 3D environment.
+             space within a 3D environment. Cells are small value objects (one
+             byte of wall and state flags) stored contiguously by Quest, which
+             locates neighbors by index.
 *******************************************************************************/
 
 #ifndef CELL_H_
@@ -24,26 +26,22 @@ enum Side {
   NUM_SIDES
 };
 
+const unsigned char ALL_WALLS = (1 << NUM_SIDES) - 1;
+const unsigned char VISITED_FLAG = 1 << NUM_SIDES;
+
+int oppositeSide(int side);
+
 class Cell {
  public:
   Cell();
-  ~Cell();
   bool setVisited(bool visited);
-  int setTexture(int side, int textureNo);
-  Cell *setNeighbor(int side, Cell *cell);
+  void setWall(int side, bool present);
   void removeWall(int side);
-  int removeRandomWall();
-  bool hasBeenVisited() const;
-  bool hasWallAt(int side) const;
-  bool hasNeighborAt(int side) const;
-  void draw(int x, int y, int perspective);
+  bool hasBeenVisited() const { return (bits_ & VISITED_FLAG) != 0; }
+  bool hasWallAt(int side) const { return (bits_ & (1 << side)) != 0; }
+  unsigned char getWalls() const { return bits_ & ALL_WALLS; }
  private:
-   bool walls_[NUM_SIDES],
-     visited_;
-   Cell *neighbors_[NUM_SIDES];
-   int textures_[NUM_SIDES];
-
-   int oppositeSide(int side);
+  unsigned char bits_;
 };
 
 #endif  // CELL_H_
@@ -70,9 +70,10 @@ void Character::initialize(int type, Quest *quest) {
     red_ = 0.0;
     green_ = 0.0;
     blue_ = 0.5;
-    x_ = rand() % DEFAULT_MAZE_WIDTH + CELL_SIZE / 2.0;
-    y_ = rand() % DEFAULT_MAZE_HEIGHT + CELL_SIZE / 2.0;
-    rotation_ = rand() % 360;
+    Random &random = quest_->getRandom();
+    x_ = random.nextInt(quest_->getWidth()) + CELL_SIZE / 2.0;
+    y_ = random.nextInt(quest_->getHeight()) + CELL_SIZE / 2.0;
+    rotation_ = random.nextInt(360);
   }
 }
 
@@ -120,6 +121,23 @@ double Character::getNextZ() const {
   return z_;  // temporary: update later
 }
 
+//------------------------------------------------------------------------------
+//      Method: setPosition
+//
+// Description: Places the character at a given location and orientation,
+//              without collision checks.
+//
+//      Inputs: x, y     - The character's new coordinates.
+//              rotation - The character's new rotation, in degrees.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Character::setPosition(double x, double y, double rotation) {
+  x_ = x;
+  y_ = y;
+  rotation_ = rotation;
+}
+
 //------------------------------------------------------------------------------
 //      Method: moveForward
 //
@@ -48,9 +48,11 @@ class Character {
   double getRed() const { return red_; }
   double getGreen() const { return green_; }
   double getBlue() const { return blue_; }
+  double getCollisionRadius() const { return collisionRadius_; }
   double getNextX() const;
   double getNextY() const;
   double getNextZ() const;
+  void setPosition(double x, double y, double rotation);
   void act(Character *player);
   void moveForward();
   void moveBackward();
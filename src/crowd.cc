@@ -0,0 +1,354 @@
+/*******************************************************************************
+   Filename: crowd.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'CrowdRenderer' class, which draws any number of
+             characters with a single call.
+*******************************************************************************/
+
+#include <cstddef>
+#include <cstdio>
+#include "crowd.h"
+
+// Each character is a vertical quad through its position, facing along its
+// rotation: 'corner' is (sideways offset in radii, height fraction).
+static const char *CROWD_VERTEX_SHADER =
+  "#version 120\n"
+  "attribute vec2 corner;\n"
+  "attribute vec4 placement;\n"  // x, y, z, rotation
+  "attribute vec2 size;\n"       // radius, height
+  "attribute vec3 color;\n"
+  "void main() {\n"
+  "  float angle = radians(placement.w);\n"
+  "  vec3 offset = vec3(-sin(angle) * corner.x * size.x,\n"
+  "                     cos(angle) * corner.x * size.x, corner.y * size.y);\n"
+  "  gl_Position = gl_ModelViewProjectionMatrix *\n"
+  "                vec4(placement.xyz + offset, 1.0);\n"
+  "  gl_FrontColor = vec4(color, 1.0);\n"
+  "}\n";
+static const char *CROWD_FRAGMENT_SHADER =
+  "#version 120\n"
+  "void main() {\n"
+  "  gl_FragColor = gl_Color;\n"
+  "}\n";
+static const float CROWD_QUAD[4][2] = {{1, 0}, {1, 1}, {-1, 1}, {-1, 0}};
+
+//------------------------------------------------------------------------------
+//      Method: compileShader
+//
+// Description: A static helper that compiles a shader, reporting any errors.
+//
+//      Inputs: type   - GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+//              source - The shader's GLSL source.
+//
+//     Outputs: The shader object, or 0 if compilation failed.
+//------------------------------------------------------------------------------
+static GLuint compileShader(GLenum type, const char *source) {
+  GLuint shader = glCreateShader(type);
+  GLint isCompiled = GL_FALSE;
+
+  glShaderSource(shader, 1, &source, NULL);
+  glCompileShader(shader);
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+  if (!isCompiled) {
+    char log[1024];
+    glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+    cerr << "Error: could not compile crowd shader: " << log << endl;
+    glDeleteShader(shader);
+    return 0;
+  }
+
+  return shader;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCrowdInstance
+//
+// Description: Describes a character, as it currently stands, as one crowd
+//              instance.
+//
+//      Inputs: character - The character of interest.
+//
+//     Outputs: The character's instance attributes.
+//------------------------------------------------------------------------------
+CrowdInstance getCrowdInstance(const Character *character) {
+  CrowdInstance instance = {(float) character->getX(),
+                            (float) character->getY(),
+                            (float) character->getZ(),
+                            (float) character->getRotation(),
+                            (float) character->getCollisionRadius(),
+                            (float) character->getHeight(),
+                            (float) character->getRed(),
+                            (float) character->getGreen(),
+                            (float) character->getBlue()};
+
+  return instance;
+}
+
+//------------------------------------------------------------------------------
+//      Method: CrowdRenderer
+//
+// Description: Constructs an empty CrowdRenderer. GL resources are created on
+//              the first 'draw'.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+CrowdRenderer::CrowdRenderer() {
+  isInitialized_ = false;
+  isInstanced_ = false;
+  program_ = 0;
+  quadBuffer_ = 0;
+  instanceBuffer_ = 0;
+  cornerLocation_ = -1;
+  placementLocation_ = -1;
+  sizeLocation_ = -1;
+  colorLocation_ = -1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~CrowdRenderer
+//
+// Description: Destructs the CrowdRenderer, releasing its GL resources.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+CrowdRenderer::~CrowdRenderer() {
+  if (program_) {
+    glDeleteProgram(program_);
+  }
+  if (quadBuffer_) {
+    glDeleteBuffers(1, &quadBuffer_);
+  }
+  if (instanceBuffer_) {
+    glDeleteBuffers(1, &instanceBuffer_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: clear
+//
+// Description: Empties the crowd in preparation for a new frame.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::clear() {
+  instances_.clear();
+}
+
+//------------------------------------------------------------------------------
+//      Method: add
+//
+// Description: Adds a character, as described by a given instance, to the
+//              crowd.
+//
+//      Inputs: instance - The character's position, size, and color.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::add(const CrowdInstance &instance) {
+  instances_.push_back(instance);
+}
+
+//------------------------------------------------------------------------------
+//      Method: draw
+//
+// Description: Draws every character in the crowd with a single call, by
+//              instancing if possible (see 'initialize'), otherwise as one
+//              CPU-built batch.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::draw() {
+  if (!isInitialized_) {
+    initialize();
+  }
+  if (instances_.empty()) {
+    return;
+  }
+  if (isInstanced_) {
+    drawInstanced();
+  } else {
+    drawBatched();
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumInstances
+//
+// Description: Returns the number of characters in the crowd.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of characters added since the last 'clear'.
+//------------------------------------------------------------------------------
+int CrowdRenderer::getNumInstances() const {
+  return instances_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: isInstanced
+//
+// Description: Determines whether the crowd is drawn by instancing (valid
+//              after the first 'draw').
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if instancing is used, 'false' if the CPU batch
+//              fallback is.
+//------------------------------------------------------------------------------
+bool CrowdRenderer::isInstanced() const {
+  return isInstanced_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: initialize
+//
+// Description: A private method that sets up instanced drawing if the GL
+//              context supports it (version 3.3 or later, which provides
+//              instanced draws and per-instance attributes) and the crowd
+//              shaders build.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::initialize() {
+  const char *version = (const char *) glGetString(GL_VERSION);
+  int major = 0,
+      minor = 0;
+
+  isInitialized_ = true;
+  if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+      major * 10 + minor < 33) {
+    return;
+  }
+
+  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, CROWD_VERTEX_SHADER),
+         fragmentShader = compileShader(GL_FRAGMENT_SHADER,
+                                        CROWD_FRAGMENT_SHADER);
+  if (!vertexShader || !fragmentShader) {
+    return;
+  }
+  program_ = glCreateProgram();
+  glAttachShader(program_, vertexShader);
+  glAttachShader(program_, fragmentShader);
+  glLinkProgram(program_);
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  GLint isLinked = GL_FALSE;
+  glGetProgramiv(program_, GL_LINK_STATUS, &isLinked);
+  if (!isLinked) {
+    glDeleteProgram(program_);
+    program_ = 0;
+    return;
+  }
+  cornerLocation_ = glGetAttribLocation(program_, "corner");
+  placementLocation_ = glGetAttribLocation(program_, "placement");
+  sizeLocation_ = glGetAttribLocation(program_, "size");
+  colorLocation_ = glGetAttribLocation(program_, "color");
+  glGenBuffers(1, &quadBuffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, quadBuffer_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(CROWD_QUAD), CROWD_QUAD,
+               GL_STATIC_DRAW);
+  glGenBuffers(1, &instanceBuffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  isInstanced_ = true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawInstanced
+//
+// Description: A private method that uploads this frame's instances to the
+//              instance buffer (orphaning the previous frame's storage) and
+//              draws one shared quad per instance with a single call.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::drawInstanced() {
+  GLsizei stride = sizeof(CrowdInstance);
+
+  glUseProgram(program_);
+  glBindBuffer(GL_ARRAY_BUFFER, quadBuffer_);
+  glEnableVertexAttribArray(cornerLocation_);
+  glVertexAttribPointer(cornerLocation_, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+  glBufferData(GL_ARRAY_BUFFER, instances_.size() * stride, NULL,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, instances_.size() * stride,
+                  &instances_[0]);
+  glEnableVertexAttribArray(placementLocation_);
+  glVertexAttribPointer(placementLocation_, 4, GL_FLOAT, GL_FALSE, stride,
+                        (const GLvoid *) offsetof(CrowdInstance, x));
+  glVertexAttribDivisor(placementLocation_, 1);
+  glEnableVertexAttribArray(sizeLocation_);
+  glVertexAttribPointer(sizeLocation_, 2, GL_FLOAT, GL_FALSE, stride,
+                        (const GLvoid *) offsetof(CrowdInstance, radius));
+  glVertexAttribDivisor(sizeLocation_, 1);
+  glEnableVertexAttribArray(colorLocation_);
+  glVertexAttribPointer(colorLocation_, 3, GL_FLOAT, GL_FALSE, stride,
+                        (const GLvoid *) offsetof(CrowdInstance, red));
+  glVertexAttribDivisor(colorLocation_, 1);
+
+  glDrawArraysInstanced(GL_QUADS, 0, 4, instances_.size());
+
+  glVertexAttribDivisor(placementLocation_, 0);
+  glVertexAttribDivisor(sizeLocation_, 0);
+  glVertexAttribDivisor(colorLocation_, 0);
+  glDisableVertexAttribArray(cornerLocation_);
+  glDisableVertexAttribArray(placementLocation_);
+  glDisableVertexAttribArray(sizeLocation_);
+  glDisableVertexAttribArray(colorLocation_);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glUseProgram(0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawBatched
+//
+// Description: A private method that expands every instance into the four
+//              colored vertices of its quad (as the vertex shader would) and
+//              draws them all from one client-side vertex array.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void CrowdRenderer::drawBatched() {
+  vertices_.resize(instances_.size() * 4 * 6);
+  float *vertex = &vertices_[0];
+
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    const CrowdInstance &c = instances_[i];
+    float angle = c.rotation * (float) (PI / 180.0),
+          sideX = -sinf(angle) * c.radius,
+          sideY = cosf(angle) * c.radius;
+    for (int k = 0; k < 4; ++k) {
+      *vertex++ = c.x + CROWD_QUAD[k][0] * sideX;
+      *vertex++ = c.y + CROWD_QUAD[k][0] * sideY;
+      *vertex++ = c.z + CROWD_QUAD[k][1] * c.height;
+      *vertex++ = c.red;
+      *vertex++ = c.green;
+      *vertex++ = c.blue;
+    }
+  }
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), &vertices_[0]);
+  glColorPointer(3, GL_FLOAT, 6 * sizeof(float), &vertices_[3]);
+  glDrawArrays(GL_QUADS, 0, instances_.size() * 4);
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+   Filename: crowd.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'CrowdRenderer' class, which draws any number of
+             characters with a single call: each frame, the position,
+             rotation, size, and color of every character are gathered into
+             one buffer, from which a small vertex shader places one instance
+             of a shared quad per character. Where instancing is unavailable,
+             the quads are expanded on the CPU and drawn as one vertex array.
+*******************************************************************************/
+
+#ifndef CROWD_H_
+#define CROWD_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Character;
+
+// The per-instance attributes of one character.
+struct CrowdInstance {
+  float x,
+        y,
+        z,
+        rotation,  // in degrees, about the z-axis
+        radius,
+        height,
+        red,
+        green,
+        blue;
+};
+
+CrowdInstance getCrowdInstance(const Character *character);
+
+class CrowdRenderer {
+ public:
+  CrowdRenderer();
+  ~CrowdRenderer();
+  void clear();
+  void add(const CrowdInstance &instance);
+  void draw();
+  int getNumInstances() const;
+  bool isInstanced() const;
+ private:
+  vector<CrowdInstance> instances_;
+  vector<float> vertices_;  // CPU-expanded quads (x, y, z, r, g, b)
+  bool isInitialized_,
+       isInstanced_;
+  GLuint program_,
+         quadBuffer_,
+         instanceBuffer_;
+  GLint cornerLocation_,
+        placementLocation_,
+        sizeLocation_,
+        colorLocation_;
+
+  void initialize();
+  void drawInstanced();
+  void drawBatched();
+};
+
+#endif  // CROWD_H_
@@ -0,0 +1,176 @@
+/*******************************************************************************
+   Filename: eller.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of an 'EllerGenerator' class, which produces a perfect
+             maze one row at a time (Eller's algorithm) while keeping only the
+             current row's state in memory.
+*******************************************************************************/
+
+#include "eller.h"
+
+//------------------------------------------------------------------------------
+//      Method: EllerGenerator
+//
+// Description: Constructs an EllerGenerator for a maze of a given size. All
+//              working storage is proportional to the width; the height only
+//              determines when the final row is emitted.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//              random        - Stream for the generator's random choices.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+EllerGenerator::EllerGenerator(int width, int height, Random random) {
+  width_ = width;
+  height_ = height;
+  y_ = 0;
+  random_ = random;
+  sets_.assign(width_, -1);
+  parents_.resize(width_);
+  counts_.resize(width_);
+  candidates_.resize(width_);
+  openings_.assign(width_, 0);
+  hasOpening_.resize(width_);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWidth
+//
+// Description: Returns the maze's width, measured in cells.
+//
+//      Inputs: None.
+//
+//     Outputs: The maze's width (i.e., no. of cells per row).
+//------------------------------------------------------------------------------
+int EllerGenerator::getWidth() const {
+  return width_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getHeight
+//
+// Description: Returns the maze's height, measured in cells.
+//
+//      Inputs: None.
+//
+//     Outputs: The maze's height (i.e., no. of rows to be emitted).
+//------------------------------------------------------------------------------
+int EllerGenerator::getHeight() const {
+  return height_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: nextRow
+//
+// Description: Emits the next row of the maze (rows are produced from south to
+//              north, i.e., y = 0 first). Each emitted cell's walls are final:
+//              its SOUTH walls match the previous row's NORTH openings, and
+//              every cell of the row belongs to a set that either continues
+//              north or, on the last row, has been merged with all others.
+//
+//      Inputs: row - Array of 'width' cells to be overwritten with the row.
+//
+//     Outputs: The y-coordinate of the emitted row, or -1 if all rows have
+//              already been emitted.
+//------------------------------------------------------------------------------
+int EllerGenerator::nextRow(Cell *row) {
+  if (y_ >= height_) {
+    return -1;
+  }
+
+  bool lastRow = (y_ == height_ - 1);
+  int nSets = 0;
+
+  // renumber carried sets compactly and give every other cell a new set
+  for (int x = 0; x < width_; ++x) {
+    counts_[x] = -1;  // temporarily maps old labels to new ones
+  }
+  for (int x = 0; x < width_; ++x) {
+    row[x] = Cell();
+    if (openings_[x]) {
+      row[x].removeWall(SOUTH);
+    }
+    if (sets_[x] >= 0) {
+      if (counts_[sets_[x]] < 0) {
+        counts_[sets_[x]] = nSets++;
+      }
+      sets_[x] = counts_[sets_[x]];
+    }
+  }
+  for (int x = 0; x < width_; ++x) {
+    if (sets_[x] < 0) {
+      sets_[x] = nSets++;
+    }
+  }
+  for (int i = 0; i < nSets; ++i) {
+    parents_[i] = i;
+  }
+
+  // randomly join horizontally adjacent cells of different sets (all of them
+  // on the last row, so that the maze ends up connected)
+  for (int x = 0; x + 1 < width_; ++x) {
+    int a = findSet(sets_[x]), b = findSet(sets_[x + 1]);
+    if (a != b && (lastRow || random_.nextInt(2))) {
+      row[x].removeWall(EAST);
+      row[x + 1].removeWall(WEST);
+      parents_[a] = b;
+    }
+  }
+  if (lastRow) {
+    ++y_;
+    return y_ - 1;
+  }
+
+  // open random northward passages, at least one per set (chosen uniformly
+  // among the set's cells via reservoir sampling)
+  for (int i = 0; i < nSets; ++i) {
+    counts_[i] = 0;
+    hasOpening_[i] = 0;
+  }
+  for (int x = 0; x < width_; ++x) {
+    int set = findSet(sets_[x]);
+    openings_[x] = random_.nextInt(2);
+    hasOpening_[set] |= openings_[x];
+    if (random_.nextInt(++counts_[set]) == 0) {
+      candidates_[set] = x;
+    }
+  }
+  for (int x = 0; x < width_; ++x) {
+    int set = findSet(sets_[x]);
+    if (!hasOpening_[set]) {
+      openings_[candidates_[set]] = 1;
+      hasOpening_[set] = 1;
+    }
+  }
+  for (int x = 0; x < width_; ++x) {
+    if (openings_[x]) {
+      row[x].removeWall(NORTH);
+      sets_[x] = findSet(sets_[x]);
+    } else {
+      sets_[x] = -1;
+    }
+  }
+
+  return y_++;
+}
+
+//------------------------------------------------------------------------------
+//      Method: findSet
+//
+// Description: A private method that returns the representative label of the
+//              set containing a given label (union-find with path halving).
+//
+//      Inputs: label - The set label of interest.
+//
+//     Outputs: The representative label.
+//------------------------------------------------------------------------------
+int EllerGenerator::findSet(int label) {
+  while (parents_[label] != label) {
+    parents_[label] = parents_[parents_[label]];
+    label = parents_[label];
+  }
+
+  return label;
+}
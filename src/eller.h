@@ -0,0 +1,43 @@
+/*******************************************************************************
+   Filename: eller.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of an 'EllerGenerator' class, which produces a perfect
+             maze one row at a time (Eller's algorithm) while keeping only the
+             current row's state in memory.
+*******************************************************************************/
+
+#ifndef ELLER_H_
+#define ELLER_H_
+
+#include <vector>
+#include "cell.h"
+#include "random.h"
+
+using namespace std;
+
+class Cell;
+
+class EllerGenerator {
+ public:
+  EllerGenerator(int width, int height, Random random);
+  int getWidth() const;
+  int getHeight() const;
+  int nextRow(Cell *row);
+ private:
+  int width_,
+      height_,
+      y_;
+  Random random_;
+  vector<int> sets_,
+              parents_,
+              counts_,
+              candidates_;
+  vector<unsigned char> openings_,
+                        hasOpening_;
+
+  int findSet(int label);
+};
+
+#endif  // ELLER_H_
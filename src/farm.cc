@@ -0,0 +1,173 @@
+/*******************************************************************************
+   Filename: farm.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definitions of a headless quest "farm," which generates many
+             seeded quests in parallel and analyzes the layout of each (no
+             window or GL context is required).
+*******************************************************************************/
+
+#include "farm.h"
+
+//------------------------------------------------------------------------------
+//      Method: analyzeQuest
+//
+// Description: Computes layout statistics of a given quest: the length of the
+//              shortest path from the start to the finish (via breadth-first
+//              search), the number of dead ends and junctions, and the mean
+//              number of onward passages at a junction (i.e., openings minus
+//              the one the player arrived through).
+//
+//      Inputs: quest - The quest of interest.
+//
+//     Outputs: The quest's statistics ('solutionLength' is -1 if the finish
+//              cannot be reached; 'generationTime' is left at 0).
+//------------------------------------------------------------------------------
+QuestStats analyzeQuest(const Quest &quest) {
+  QuestStats stats = {quest.getSeed(), -1, 0, 0, 0.0, 0.0};
+  int nCells = quest.getWidth() * quest.getHeight(),
+      start = quest.getCellIndex(quest.getStartX(), 0),
+      finish = quest.getCellIndex(quest.getFinishX(), quest.getHeight() - 1);
+  long long nChoices = 0;
+  vector<int> distances(nCells, -1),
+              queue(nCells);
+  int head = 0,
+      tail = 0;
+
+  // classify cells by their number of openings
+  for (int i = 0; i < nCells; ++i) {
+    int nOpenings = 0;
+    for (int side = NORTH; side <= WEST; ++side) {
+      if (!quest.getCell(i).hasWallAt(side)) {
+        ++nOpenings;
+      }
+    }
+    if (nOpenings == 1) {
+      ++stats.deadEnds;
+    } else if (nOpenings >= 3) {
+      ++stats.junctions;
+      nChoices += nOpenings - 1;
+    }
+  }
+  if (stats.junctions > 0) {
+    stats.branchingFactor = (double) nChoices / stats.junctions;
+  }
+
+  // find the shortest path from start to finish
+  distances[start] = 1;
+  queue[tail++] = start;
+  while (head < tail && distances[finish] < 0) {
+    int cellIndex = queue[head++];
+    for (int side = NORTH; side <= WEST; ++side) {
+      int neighbor = quest.getNeighborIndex(cellIndex, side);
+      if (neighbor >= 0 && distances[neighbor] < 0 &&
+          !quest.getCell(cellIndex).hasWallAt(side)) {
+        distances[neighbor] = distances[cellIndex] + 1;
+        queue[tail++] = neighbor;
+      }
+    }
+  }
+  stats.solutionLength = distances[finish];
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+//      Method: farmQuests
+//
+// Description: A static helper run by each farm worker thread. Repeatedly
+//              claims the next quest number, generates and analyzes that
+//              quest, and stores its statistics, until no quests remain. Each
+//              quest is generated on a single thread, since the farm already
+//              keeps every core busy.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//              firstSeed     - Seed of the first quest (quest i uses
+//                              firstSeed + i).
+//              results       - Statistics of all quests, indexed by quest.
+//              nextQuest     - Shared index of the next quest to be claimed.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+static void farmQuests(int width, int height, uint64_t firstSeed,
+                       vector<QuestStats> *results, atomic<int> *nextQuest) {
+  int i;
+
+  while ((i = (*nextQuest)++) < (int) results->size()) {
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    Quest quest(DEFAULT_QUEST_NO, width, height, DEFAULT_PERSPECTIVE,
+                firstSeed + i, 1);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                              startTime).count();
+    (*results)[i] = analyzeQuest(quest);
+    (*results)[i].generationTime = seconds;
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: runQuestFarm
+//
+// Description: Generates a given number of seeded quests in parallel, writes
+//              the statistics of each (see 'analyzeQuest') to a CSV file, one
+//              row per quest in seed order, and reports overall throughput in
+//              quests per second.
+//
+//      Inputs: nQuests       - Number of quests to be generated.
+//              width, height - Maze dimensions, measured in cells.
+//              filename      - Path of the CSV file to be written.
+//              firstSeed     - Seed of the first quest (quest i uses
+//                              firstSeed + i).
+//              nThreads      - Number of worker threads (0 to use all cores).
+//
+//     Outputs: 0 if successful, 1 if an error occurs.
+//------------------------------------------------------------------------------
+int runQuestFarm(int nQuests, int width, int height, const char *filename,
+                 uint64_t firstSeed, int nThreads) {
+  if (nQuests <= 0 || width <= 0 || height <= 0) {
+    cerr << "Error: invalid farm of " << nQuests << " " << width << "x"
+         << height << " quests." << endl;
+    return 1;
+  }
+  FILE *file = fopen(filename, "w");
+  if (!file) {
+    cerr << "Error: could not open \"" << filename << "\"." << endl;
+    return 1;
+  }
+  if (nThreads <= 0) {
+    nThreads = max(1, (int) thread::hardware_concurrency());
+  }
+
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  vector<QuestStats> results(nQuests);
+  atomic<int> nextQuest(0);
+  vector<thread> workers;
+  for (int i = 0; i < min(nThreads, nQuests); ++i) {
+    workers.push_back(thread(farmQuests, width, height, firstSeed, &results,
+                             &nextQuest));
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            startTime).count();
+
+  fprintf(file, "seed,width,height,solution_length,dead_ends,junctions,"
+                "branching_factor,generation_ms\n");
+  for (int i = 0; i < nQuests; ++i) {
+    fprintf(file, "%llu,%d,%d,%d,%d,%d,%.4f,%.3f\n",
+            (unsigned long long) results[i].seed, width, height,
+            results[i].solutionLength, results[i].deadEnds,
+            results[i].junctions, results[i].branchingFactor,
+            results[i].generationTime * 1000.0);
+  }
+  if (fclose(file) != 0) {
+    cerr << "Error: could not write \"" << filename << "\"." << endl;
+    return 1;
+  }
+  cout << "Farmed " << nQuests << " " << width << "x" << height
+       << " quests on " << workers.size() << " threads: "
+       << nQuests / seconds << " quests/s" << endl;
+
+  return 0;
+}
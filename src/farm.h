@@ -0,0 +1,33 @@
+/*******************************************************************************
+   Filename: farm.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declarations of a headless quest "farm," which generates many
+             seeded quests in parallel and analyzes the layout of each (no
+             window or GL context is required).
+*******************************************************************************/
+
+#ifndef FARM_H_
+#define FARM_H_
+
+#include <stdint.h>
+#include "quest.h"
+
+class Quest;
+
+// Layout statistics of a single quest.
+struct QuestStats {
+  uint64_t seed;
+  int solutionLength,  // cells on the shortest start-to-finish path
+      deadEnds,        // cells with a single opening
+      junctions;       // cells with three or more openings
+  double branchingFactor,  // mean onward choices at a junction
+         generationTime;   // seconds
+};
+
+QuestStats analyzeQuest(const Quest &quest);
+int runQuestFarm(int nQuests, int width, int height, const char *filename,
+                 uint64_t firstSeed, int nThreads = 0);
+
+#endif  // FARM_H_
@@ -0,0 +1,153 @@
+/*******************************************************************************
+   Filename: framebuffer.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Framebuffer' class, which owns an offscreen
+             framebuffer with color and depth buffers.
+*******************************************************************************/
+
+#include "framebuffer.h"
+
+//------------------------------------------------------------------------------
+//      Method: Framebuffer
+//
+// Description: Constructs an empty Framebuffer. Nothing is created until the
+//              first 'resize'.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Framebuffer::Framebuffer() {
+  id_ = 0;
+  colorBuffer_ = 0;
+  depthBuffer_ = 0;
+  width_ = 0;
+  height_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~Framebuffer
+//
+// Description: Destructs the Framebuffer, releasing its buffers (the context
+//              that created them must still be current, unless 'release' has
+//              already been called).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Framebuffer::~Framebuffer() {
+  release();
+}
+
+//------------------------------------------------------------------------------
+//      Method: resize
+//
+// Description: (Re)creates the framebuffer and its buffers if it does not
+//              already have a given size. The framebuffer bound beforehand is
+//              bound again afterward.
+//
+//      Inputs: width, height - The desired size, in pixels.
+//
+//     Outputs: Returns 'true' if the framebuffer is complete, 'false'
+//              (leaving it released) otherwise.
+//------------------------------------------------------------------------------
+bool Framebuffer::resize(int width, int height) {
+  GLint previous;
+
+  if (id_ && width == width_ && height == height_) {
+    return true;
+  }
+  release();
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+  glGenFramebuffers(1, &id_);
+  glGenRenderbuffers(1, &colorBuffer_);
+  glGenRenderbuffers(1, &depthBuffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, id_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, colorBuffer_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depthBuffer_);
+
+  bool isComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+                    GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, previous);
+  if (!isComplete) {
+    release();
+  }
+
+  return isComplete;
+}
+
+//------------------------------------------------------------------------------
+//      Method: release
+//
+// Description: Deletes the framebuffer and its buffers, if any.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Framebuffer::release() {
+  if (id_) {
+    glDeleteFramebuffers(1, &id_);
+    glDeleteRenderbuffers(1, &colorBuffer_);
+    glDeleteRenderbuffers(1, &depthBuffer_);
+  }
+  id_ = 0;
+  colorBuffer_ = 0;
+  depthBuffer_ = 0;
+  width_ = 0;
+  height_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getId
+//
+// Description: Returns the framebuffer's name, for binding.
+//
+//      Inputs: None.
+//
+//     Outputs: The framebuffer's name, or 0 if it has not been created.
+//------------------------------------------------------------------------------
+GLuint Framebuffer::getId() const {
+  return id_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWidth
+//
+// Description: Returns the framebuffer's width.
+//
+//      Inputs: None.
+//
+//     Outputs: The width, in pixels (0 if not created).
+//------------------------------------------------------------------------------
+int Framebuffer::getWidth() const {
+  return width_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getHeight
+//
+// Description: Returns the framebuffer's height.
+//
+//      Inputs: None.
+//
+//     Outputs: The height, in pixels (0 if not created).
+//------------------------------------------------------------------------------
+int Framebuffer::getHeight() const {
+  return height_;
+}
@@ -0,0 +1,37 @@
+/*******************************************************************************
+   Filename: framebuffer.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Framebuffer' class, which owns an offscreen
+             framebuffer with an RGBA color buffer and a 24-bit depth buffer
+             (both renderbuffers). Shared by the overview cache, the
+             resolution scaler, and the headless context.
+*******************************************************************************/
+
+#ifndef FRAMEBUFFER_H_
+#define FRAMEBUFFER_H_
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // framebuffer objects (OpenGL 3.0)
+#endif
+#include <GL/glut.h>
+
+class Framebuffer {
+ public:
+  Framebuffer();
+  ~Framebuffer();
+  bool resize(int width, int height);
+  void release();
+  GLuint getId() const;
+  int getWidth() const;
+  int getHeight() const;
+ private:
+  GLuint id_,
+         colorBuffer_,
+         depthBuffer_;
+  int width_,
+      height_;
+};
+
+#endif  // FRAMEBUFFER_H_
@@ -0,0 +1,159 @@
+/*******************************************************************************
+   Filename: frustum.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Frustum' class representing the camera's view
+             volume.
+*******************************************************************************/
+
+#include <cmath>
+#include <GL/gl.h>
+#include "frustum.h"
+
+//------------------------------------------------------------------------------
+//      Method: Frustum
+//
+// Description: Constructs a Frustum that rejects nothing (see 'extract').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Frustum::Frustum() {
+  for (int k = 0; k < 2; ++k) {
+    a_[k] = b_[k] = c_[k] = _mm_setzero_ps();
+    d_[k] = _mm_set1_ps(1.0f);
+  }
+  eyeX_ = eyeY_ = eyeZ_ = 0.0f;
+  farDistance_ = HUGE_VALF;
+}
+
+//------------------------------------------------------------------------------
+//      Method: extract
+//
+// Description: Sets the frustum to the view volume of the current projection
+//              and modelview matrices.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Frustum::extract() {
+  double projection[16],
+         modelview[16];
+
+  glGetDoublev(GL_PROJECTION_MATRIX, projection);
+  glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+  setMatrices(projection, modelview);
+}
+
+//------------------------------------------------------------------------------
+//      Method: setMatrices
+//
+// Description: Sets the frustum to the view volume of given projection and
+//              modelview matrices. Its six planes are read off the rows of
+//              their product (Gribb and Hartmann's method); the eye position
+//              is recovered from the modelview matrix (assumed rigid, as
+//              'gluLookAt' builds), and the far distance from the projection
+//              matrix (assumed to be a perspective projection).
+//
+//      Inputs: projection - Column-major 4x4 projection matrix.
+//              modelview  - Column-major 4x4 modelview matrix.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Frustum::setMatrices(const double *projection, const double *modelview) {
+  double m[16],
+         planes[8][4];
+
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      m[col * 4 + row] = 0.0;
+      for (int k = 0; k < 4; ++k) {
+        m[col * 4 + row] += projection[k * 4 + row] * modelview[col * 4 + k];
+      }
+    }
+  }
+  // rows 0, 1, and 2 give the left/right, bottom/top, and near/far pairs
+  for (int p = 0; p < NUM_FRUSTUM_PLANES; ++p) {
+    int row = p / 2;
+    double sign = (p % 2 == 0) ? 1.0 : -1.0;
+    for (int k = 0; k < 4; ++k) {
+      planes[p][k] = m[k * 4 + 3] + sign * m[k * 4 + row];
+    }
+  }
+  for (int p = NUM_FRUSTUM_PLANES; p < 8; ++p) {
+    planes[p][0] = planes[p][1] = planes[p][2] = 0.0;
+    planes[p][3] = 1.0;
+  }
+  for (int k = 0; k < 2; ++k) {
+    const double (*q)[4] = &planes[k * 4];
+    a_[k] = _mm_setr_ps(q[0][0], q[1][0], q[2][0], q[3][0]);
+    b_[k] = _mm_setr_ps(q[0][1], q[1][1], q[2][1], q[3][1]);
+    c_[k] = _mm_setr_ps(q[0][2], q[1][2], q[2][2], q[3][2]);
+    d_[k] = _mm_setr_ps(q[0][3], q[1][3], q[2][3], q[3][3]);
+  }
+
+  const double *t = &modelview[12];
+  eyeX_ = -(modelview[0] * t[0] + modelview[1] * t[1] + modelview[2] * t[2]);
+  eyeY_ = -(modelview[4] * t[0] + modelview[5] * t[1] + modelview[6] * t[2]);
+  eyeZ_ = -(modelview[8] * t[0] + modelview[9] * t[1] +
+            modelview[10] * t[2]);
+  farDistance_ = projection[14] / (projection[10] + 1.0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: isBoxVisible
+//
+// Description: Determines whether any part of an axis-aligned box may be
+//              visible: the box's corner farthest along each plane's normal
+//              must lie inside all six planes, and the box's nearest point must
+//              lie within the far distance of the eye (so that boxes in the
+//              corners of the far plane are cut off as well). The plane tests
+//              are done four at a time.
+//
+//      Inputs: minX, minY, minZ - The box's minimum corner.
+//              maxX, maxY, maxZ - The box's maximum corner.
+//
+//     Outputs: Returns 'true' if the box may be visible, 'false' if it is
+//              certainly not.
+//------------------------------------------------------------------------------
+bool Frustum::isBoxVisible(float minX, float minY, float minZ, float maxX,
+                           float maxY, float maxZ) const {
+  __m128 lowX = _mm_set1_ps(minX), highX = _mm_set1_ps(maxX),
+         lowY = _mm_set1_ps(minY), highY = _mm_set1_ps(maxY),
+         lowZ = _mm_set1_ps(minZ), highZ = _mm_set1_ps(maxZ);
+  int outside = 0;
+
+  for (int k = 0; k < 2; ++k) {
+    __m128 distance = _mm_add_ps(
+      _mm_add_ps(_mm_max_ps(_mm_mul_ps(a_[k], lowX), _mm_mul_ps(a_[k], highX)),
+                 _mm_max_ps(_mm_mul_ps(b_[k], lowY), _mm_mul_ps(b_[k], highY))),
+      _mm_add_ps(_mm_max_ps(_mm_mul_ps(c_[k], lowZ), _mm_mul_ps(c_[k], highZ)),
+                 d_[k]));
+    outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_setzero_ps()));
+  }
+  if (outside) {
+    return false;
+  }
+
+  float dx = fmaxf(fmaxf(minX - eyeX_, eyeX_ - maxX), 0.0f),
+        dy = fmaxf(fmaxf(minY - eyeY_, eyeY_ - maxY), 0.0f),
+        dz = fmaxf(fmaxf(minZ - eyeZ_, eyeZ_ - maxZ), 0.0f);
+
+  return dx * dx + dy * dy + dz * dz <= farDistance_ * farDistance_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getFarDistance
+//
+// Description: Returns the distance beyond which nothing is visible.
+//
+//      Inputs: None.
+//
+//     Outputs: The far distance, in cells.
+//------------------------------------------------------------------------------
+double Frustum::getFarDistance() const {
+  return farDistance_;
+}
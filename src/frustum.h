@@ -0,0 +1,40 @@
+/*******************************************************************************
+   Filename: frustum.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Frustum' class representing the camera's view
+             volume, extracted from the current OpenGL projection and modelview
+             matrices, against which axis-aligned bounding boxes are tested
+             with SSE (four planes per instruction).
+*******************************************************************************/
+
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include <xmmintrin.h>
+
+const int NUM_FRUSTUM_PLANES = 6;
+
+class Frustum {
+ public:
+  Frustum();
+  void extract();
+  void setMatrices(const double *projection, const double *modelview);
+  bool isBoxVisible(float minX, float minY, float minZ, float maxX,
+                    float maxY, float maxZ) const;
+  double getFarDistance() const;
+ private:
+  // plane coefficients (a, b, c, d) in structure-of-arrays form, padded to
+  // eight planes with planes that reject nothing
+  __m128 a_[2],
+         b_[2],
+         c_[2],
+         d_[2];
+  float eyeX_,
+        eyeY_,
+        eyeZ_,
+        farDistance_;
+};
+
+#endif  // FRUSTUM_H_
@@ -0,0 +1,166 @@
+/*******************************************************************************
+   Filename: headless.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'HeadlessContext' class, which provides an
+             OpenGL context and an offscreen framebuffer without a window.
+*******************************************************************************/
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "headless.h"
+
+//------------------------------------------------------------------------------
+//      Method: getSurfacelessDisplay
+//
+// Description: A static helper that returns an EGL display that needs no
+//              window system: Mesa's surfaceless platform if available,
+//              otherwise the default display.
+//
+//      Inputs: None.
+//
+//     Outputs: The display, or EGL_NO_DISPLAY if none is available.
+//------------------------------------------------------------------------------
+static EGLDisplay getSurfacelessDisplay() {
+  const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+    (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+      eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+  if (extensions && getPlatformDisplay &&
+      strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+    return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                              EGL_DEFAULT_DISPLAY, NULL);
+  }
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+//------------------------------------------------------------------------------
+//      Method: HeadlessContext
+//
+// Description: Constructs a HeadlessContext with no context yet (see
+//              'create').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+HeadlessContext::HeadlessContext() {
+  display_ = EGL_NO_DISPLAY;
+  context_ = EGL_NO_CONTEXT;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~HeadlessContext
+//
+// Description: Destructs the HeadlessContext, releasing its context and
+//              framebuffer.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+HeadlessContext::~HeadlessContext() {
+  release();
+}
+
+//------------------------------------------------------------------------------
+//      Method: create
+//
+// Description: Creates a (compatibility profile) OpenGL context with no
+//              surface, makes it current on the calling thread, and binds a
+//              framebuffer of a given size, with an RGBA color buffer and a
+//              24-bit depth buffer, in place of a window's.
+//
+//      Inputs: width, height - The framebuffer's size, in pixels.
+//
+//     Outputs: Returns 'true' if successful, 'false' (after reporting the
+//              error) otherwise.
+//------------------------------------------------------------------------------
+bool HeadlessContext::create(int width, int height) {
+  EGLint major, minor, nConfigs = 0;
+  const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                     EGL_NONE};
+  EGLConfig config = (EGLConfig) 0;  // i.e., EGL_NO_CONFIG_KHR
+
+  release();
+  display_ = getSurfacelessDisplay();
+  if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, &major, &minor)) {
+    cerr << "Error: no EGL display is available." << endl;
+    display_ = EGL_NO_DISPLAY;
+    return false;
+  }
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    cerr << "Error: EGL does not support desktop OpenGL." << endl;
+    release();
+    return false;
+  }
+
+  // surfaceless displays may offer no configs at all, in which case the
+  // context is created without one (EGL_KHR_no_config_context)
+  eglChooseConfig(display_, configAttributes, &config, 1, &nConfigs);
+  if (nConfigs < 1) {
+    config = (EGLConfig) 0;
+  }
+  context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, NULL);
+  if (context_ == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_)) {
+    cerr << "Error: could not create a surfaceless OpenGL context." << endl;
+    release();
+    return false;
+  }
+
+  if (!framebuffer_.resize(width, height)) {
+    cerr << "Error: could not create a " << width << "x" << height
+         << " offscreen framebuffer." << endl;
+    release();
+    return false;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_.getId());
+  glViewport(0, 0, width, height);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: release
+//
+// Description: Deletes the framebuffer and destroys the context, if any.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void HeadlessContext::release() {
+  if (context_ != EGL_NO_CONTEXT) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    framebuffer_.release();  // while the context is still current
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display_, context_);
+  }
+  if (display_ != EGL_NO_DISPLAY) {
+    eglTerminate(display_);
+  }
+  display_ = EGL_NO_DISPLAY;
+  context_ = EGL_NO_CONTEXT;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getRenderer
+//
+// Description: Returns the name of the OpenGL renderer behind the context
+//              (e.g., "llvmpipe").
+//
+//      Inputs: None.
+//
+//     Outputs: The renderer's name, or an empty string if there is no context.
+//------------------------------------------------------------------------------
+const char *HeadlessContext::getRenderer() const {
+  if (context_ == EGL_NO_CONTEXT) {
+    return "";
+  }
+
+  return (const char *) glGetString(GL_RENDERER);
+}
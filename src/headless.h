@@ -0,0 +1,32 @@
+/*******************************************************************************
+   Filename: headless.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'HeadlessContext' class, which provides an
+             OpenGL context and an offscreen framebuffer without a window or
+             display server, via EGL's surfaceless platform (e.g., Mesa's
+             llvmpipe software renderer on a machine with no GPU). Used to
+             measure rendering cost on build and benchmark machines.
+*******************************************************************************/
+
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+#include "main.h"
+#include "framebuffer.h"
+
+class HeadlessContext {
+ public:
+  HeadlessContext();
+  ~HeadlessContext();
+  bool create(int width, int height);
+  void release();
+  const char *getRenderer() const;
+ private:
+  void *display_,  // an EGLDisplay
+       *context_;  // an EGLContext
+  Framebuffer framebuffer_;  // drawn to in place of a window's
+};
+
+#endif  // HEADLESS_H_
@@ -8,8 +8,12 @@ Description: Improves on GLUT's handling of keyboard input.
 
 #include "keys.h"
 
+using namespace std;
+
 // state of all keys, to know if multiple keys are pressed at any given time
-bool g_keystates[512] = { false };
+// (written by GLUT's callbacks, read by the simulation thread; each key is
+// independent, so relaxed ordering suffices)
+atomic<bool> g_keystates[512];
 
 // callback functions
 key_func g_upfunc = 0;
@@ -25,35 +29,35 @@ void setKeyboardUpFunc(key_func func) {
 
 bool isKeyPressed(int key) {
   if (key >= 0 && key < 512) {
-    return g_keystates[key];
+    return g_keystates[key].load(memory_order_relaxed);
   }
 
   return false;
 }
 
 void keyUpFunc(unsigned char key,int x,int y) {
-  g_keystates[key] = false;
+  g_keystates[key].store(false, memory_order_relaxed);
   if (g_upfunc) {
     g_upfunc(key, x, y);
   }
 }
 
 void keyDownFunc(unsigned char key, int x, int y) {
-  g_keystates[key] = true;
+  g_keystates[key].store(true, memory_order_relaxed);
   if (g_downfunc) {
     g_downfunc(key, x, y);
   }
 }
 
 void specialKeyUpFunc(int key, int x, int y) {
-  g_keystates[key + 256] = false;
+  g_keystates[key + 256].store(false, memory_order_relaxed);
   if (g_upfunc) {
     g_upfunc(key + 256, x, y);
   }
 }
 
 void specialKeyDownFunc(int key, int x, int y) {
-  g_keystates[key + 256] = true;
+  g_keystates[key + 256].store(true, memory_order_relaxed);
   if (g_downfunc) {
     g_downfunc(key + 256, x, y);
   }
@@ -10,6 +10,7 @@ Description: Improves on GLUT's handling of keyboard input.
 #define KEYS_H_
 
 #include <cstdlib>
+#include <atomic>
 #include <GL/glut.h>
 
 #define KEY_F1 (GLUT_KEY_F1 + 256)
@@ -0,0 +1,384 @@
+/*******************************************************************************
+   Filename: layout.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'QuestLayout' class, which parses a hand-made
+             quest board from a text definition and compiles it into a quest
+             file, and of functions that keep those compiled files cached so
+             that unchanged layouts are never parsed twice.
+*******************************************************************************/
+
+#include "layout.h"
+
+//------------------------------------------------------------------------------
+//      Method: hashLayoutSource
+//
+// Description: A static helper that returns the 64-bit FNV-1a hash of a
+//              layout's source text, used to tell whether a cached compiled
+//              layout is still up to date.
+//
+//      Inputs: text - The source text.
+//              size - Number of bytes of text.
+//
+//     Outputs: The hash.
+//------------------------------------------------------------------------------
+static uint64_t hashLayoutSource(const char *text, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ (unsigned char) text[i]) * 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isCompiledLayoutCurrent
+//
+// Description: A static helper that determines, from its header alone,
+//              whether a cached compiled layout exists, is a quest file of the
+//              current version, and was compiled from a given source text.
+//              Stale and missing caches are thus told apart quietly, before
+//              the cache is opened (which reports any problem as an error).
+//
+//      Inputs: filename   - Path of the cached compiled layout.
+//              sourceHash - Hash of the layout's current source text.
+//
+//     Outputs: Returns 'true' if the cache is current, 'false' otherwise.
+//------------------------------------------------------------------------------
+static bool isCompiledLayoutCurrent(const char *filename,
+                                    uint64_t sourceHash) {
+  QuestFileHeader header;
+  FILE *file = fopen(filename, "rb");
+
+  if (!file) {
+    return false;
+  }
+  bool isRead = fread(&header, sizeof(header), 1, file) == 1;
+  fclose(file);
+
+  return isRead &&
+         memcmp(header.magic, QUEST_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+         header.version == QUEST_FILE_VERSION &&
+         header.headerSize == sizeof(QuestFileHeader) &&
+         header.sourceHash == sourceHash;
+}
+
+//------------------------------------------------------------------------------
+//      Method: QuestLayout
+//
+// Description: Constructs an empty QuestLayout object (see 'parse').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+QuestLayout::QuestLayout() {
+  questNo_ = DEFAULT_QUEST_NO;
+  width_ = 0;
+  height_ = 0;
+  startX_ = -1;
+  finishX_ = -1;
+  seed_ = DEFAULT_SEED;
+}
+
+//------------------------------------------------------------------------------
+//      Method: parse
+//
+// Description: Parses a layout from its text definition (see layout.h).
+//
+//      Inputs: text - The definition's text.
+//              size - Number of bytes of text.
+//
+//     Outputs: Returns 'true' if the layout was parsed successfully, 'false'
+//              otherwise (after reporting the first error found).
+//------------------------------------------------------------------------------
+bool QuestLayout::parse(const char *text, size_t size) {
+  vector<string> lines;
+  string line;
+
+  // split into lines, ignoring carriage returns
+  for (size_t i = 0; i <= size; ++i) {
+    if (i == size || text[i] == '\n') {
+      lines.push_back(line);
+      line.clear();
+    } else if (text[i] != '\r') {
+      line += text[i];
+    }
+  }
+
+  textures_.clear();
+  for (int n = 0; n < lines.size(); ++n) {
+    const char *directive = lines[n].c_str();
+    unsigned long long seed;
+    int t[NUM_MATERIALS];
+
+    if (lines[n].empty() || directive[0] == '#') {
+      continue;
+    } else if (sscanf(directive, "quest %d", &questNo_) == 1) {
+      continue;
+    } else if (sscanf(directive, "seed %llu", &seed) == 1) {
+      seed_ = seed;
+    } else if (sscanf(directive, "textures %d %d %d %d", &t[0], &t[1], &t[2],
+                      &t[3]) == NUM_MATERIALS) {
+      for (int m = 0; m < NUM_MATERIALS; ++m) {
+        if (t[m] < 0 || t[m] >= NUM_TEXTURES) {
+          cerr << "Error: line " << n + 1 << ": texture index " << t[m]
+               << " is out of range (0 to " << NUM_TEXTURES - 1 << ")."
+               << endl;
+          return false;
+        }
+      }
+      textures_.assign(t, t + NUM_MATERIALS);
+    } else if (lines[n] == "map") {
+      vector<string> map;
+      for (int m = n + 1; m < lines.size(); ++m) {
+        if (lines[m].empty() || lines[m][0] != '#') {
+          map.push_back(lines[m]);
+        }
+      }
+      while (!map.empty() && map.back().empty()) {
+        map.pop_back();
+      }
+      if (textures_.empty()) {
+        for (int m = 0; m < NUM_MATERIALS; ++m) {
+          textures_.push_back(TEXTURE_OFFSET_PER_QUEST * (questNo_ - 1) + m);
+        }
+      }
+      return parseMap(map);
+    } else {
+      cerr << "Error: line " << n + 1 << ": unknown directive \"" << lines[n]
+           << "\"." << endl;
+      return false;
+    }
+  }
+  cerr << "Error: layout has no map." << endl;
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//      Method: parseMap
+//
+// Description: A private method that builds the layout's cells, start and
+//              finish, and monster spawns from the lines of its map (see
+//              layout.h).
+//
+//      Inputs: lines - The map's lines, from the north edge down.
+//
+//     Outputs: Returns 'true' if the map is valid, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestLayout::parseMap(const vector<string> &lines) {
+  size_t columns = 0;
+
+  for (int r = 0; r < lines.size(); ++r) {
+    columns = max(columns, lines[r].size());
+  }
+  if (lines.size() < 3 || lines.size() % 2 == 0 || columns < 3 ||
+      columns % 2 == 0) {
+    cerr << "Error: map must have an odd number (at least 3) of rows and "
+         << "columns." << endl;
+    return false;
+  }
+  width_ = (columns - 1) / 2;
+  height_ = (lines.size() - 1) / 2;
+  cells_.assign(width_ * height_, Cell());
+  spawns_.clear();
+  startX_ = -1;
+  finishX_ = -1;
+
+  Random random(seed_);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      Cell &cell = cells_[x + y * width_];
+      int r = 2 * (height_ - 1 - y) + 1,
+          c = 2 * x + 1;
+      char content = c < lines[r].size() ? lines[r][c] : ' ',
+           north = c < lines[r - 1].size() ? lines[r - 1][c] : ' ',
+           east = c + 1 < lines[r].size() ? lines[r][c + 1] : ' ',
+           south = c < lines[r + 1].size() ? lines[r + 1][c] : ' ';
+
+      // contents
+      if (content == 'g' || content == 'o') {
+        QuestFileSpawn spawn = {content == 'g' ? GOBLIN : ORC,
+                                (float) (x + CELL_SIZE / 2.0),
+                                (float) (y + CELL_SIZE / 2.0),
+                                (float) random.nextInt(360)};
+        spawns_.push_back(spawn);
+      } else if (content != ' ' && content != '.') {
+        cerr << "Error: map row " << r + 1 << ", column " << c + 1
+             << ": unknown cell contents '" << content << "'." << endl;
+        return false;
+      }
+
+      // walls (outer walls stay, apart from the start and finish doors)
+      if (y == height_ - 1) {
+        if (north == 'F') {
+          finishX_ = (finishX_ < 0) ? x : width_;
+        }
+      } else if (north == ' ' || north == 'D') {
+        cell.removeWall(NORTH);
+      } else if (north != '-') {
+        cerr << "Error: map row " << r << ", column " << c + 1
+             << ": unknown wall '" << north << "'." << endl;
+        return false;
+      }
+      if (x < width_ - 1) {
+        if (east == ' ' || east == 'D') {
+          cell.removeWall(EAST);
+        } else if (east != '|') {
+          cerr << "Error: map row " << r + 1 << ", column " << c + 2
+               << ": unknown wall '" << east << "'." << endl;
+          return false;
+        }
+      }
+      if (y == 0 && south == 'S') {
+        startX_ = (startX_ < 0) ? x : width_;
+      }
+    }
+  }
+  if (startX_ < 0 || startX_ >= width_ || finishX_ < 0 ||
+      finishX_ >= width_) {
+    cerr << "Error: map needs exactly one 'S' on its south edge and one 'F' "
+         << "on its north edge." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: compile
+//
+// Description: Writes the parsed layout to a quest file, recording the hash of
+//              its source so that the file can serve as a cache (see
+//              'openQuestLayout').
+//
+//      Inputs: filename   - Path of the quest file to be created.
+//              sourceHash - Hash of the layout's source text.
+//
+//     Outputs: Returns 'true' if successful, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestLayout::compile(const char *filename, uint64_t sourceHash) const {
+  QuestFileHeader header;
+  QuestFileWriter writer;
+
+  initializeQuestFileHeader(header, width_, height_, spawns_.size());
+  header.questNo = questNo_;
+  header.startX = startX_;
+  header.finishX = finishX_;
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    header.textures[m] = textures_[m];
+  }
+  header.seed = seed_;
+  header.sourceHash = sourceHash;
+  if (!writer.open(filename, header)) {
+    return false;
+  }
+  for (int y = 0; y < height_; ++y) {
+    if (!writer.writeRow(&cells_[y * width_])) {
+      return false;
+    }
+  }
+
+  return writer.finish(spawns_.empty() ? NULL : &spawns_[0]);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWidth
+//
+// Description: Returns the layout's width, measured in cells.
+//
+//      Inputs: None.
+//
+//     Outputs: The layout's width (0 until a layout has been parsed).
+//------------------------------------------------------------------------------
+int QuestLayout::getWidth() const {
+  return width_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getHeight
+//
+// Description: Returns the layout's height, measured in cells.
+//
+//      Inputs: None.
+//
+//     Outputs: The layout's height (0 until a layout has been parsed).
+//------------------------------------------------------------------------------
+int QuestLayout::getHeight() const {
+  return height_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: openQuestLayout
+//
+// Description: Opens the compiled form of a layout definition. The compiled
+//              quest file is cached next to the definition (with the
+//              QUEST_CACHE_EXTENSION extension) and is reused, without
+//              parsing, for as long as the definition's contents are
+//              unchanged; otherwise the definition is parsed and recompiled.
+//
+//      Inputs: filename - Path of the layout definition.
+//              file     - Quest file object through which the compiled layout
+//                         is to be opened.
+//
+//     Outputs: Returns 'true' if the compiled layout was opened successfully,
+//              'false' otherwise.
+//------------------------------------------------------------------------------
+bool openQuestLayout(const char *filename, QuestFile &file) {
+  FILE *source = fopen(filename, "rb");
+  if (!source) {
+    cerr << "Error: could not open \"" << filename << "\"." << endl;
+    return false;
+  }
+  string text;
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+    text.append(buffer, n);
+  }
+  fclose(source);
+  uint64_t hash = hashLayoutSource(text.data(), text.size());
+
+  // reuse the cached compiled layout if it was built from this very text
+  string cache = filename;
+  size_t dot = cache.find_last_of('.');
+  if (dot != string::npos && dot > cache.find_last_of('/') + 1) {
+    cache.erase(dot);
+  }
+  cache += QUEST_CACHE_EXTENSION;
+  if (isCompiledLayoutCurrent(cache.c_str(), hash) &&
+      file.open(cache.c_str())) {
+    return true;
+  }
+  file.close();
+
+  QuestLayout layout;
+  if (!layout.parse(text.data(), text.size())) {
+    cerr << "Error: could not parse \"" << filename << "\"." << endl;
+    return false;
+  }
+  if (!layout.compile(cache.c_str(), hash)) {
+    cerr << "Error: could not write \"" << cache << "\"." << endl;
+    return false;
+  }
+
+  return file.open(cache.c_str());
+}
+
+//------------------------------------------------------------------------------
+//      Method: getQuestLayoutFilename
+//
+// Description: Returns the path at which the layout definition of a given
+//              campaign quest is expected (e.g., "quests/quest1.hq").
+//
+//      Inputs: questNo - Integer representing a specific quest.
+//
+//     Outputs: The layout definition's path.
+//------------------------------------------------------------------------------
+string getQuestLayoutFilename(int questNo) {
+  return string(QUEST_LAYOUT_DIRECTORY) + "quest" + to_string(questNo) +
+         QUEST_LAYOUT_EXTENSION;
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+   Filename: layout.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'QuestLayout' class, which parses a hand-made
+             quest board (rooms, corridors, doors, and monsters) from a text
+             definition and compiles it into a quest file (see questfile.h).
+
+             A definition consists of directive lines followed by a map:
+
+               # comment
+               quest 1
+               textures 0 1 2 3
+               seed 1
+               map
+               +-+-F-+
+               |g    |
+               + +-+-+
+               |  D o|
+               +-S-+-+
+
+             The map has 2 * width + 1 columns and 2 * height + 1 rows, with
+             the top row along the north edge. Cell characters sit at odd
+             columns and rows: ' ' or '.' for an empty floor, 'g' for a goblin,
+             'o' for an orc. The characters between them are walls ('|', '-')
+             or passages (' ', or 'D' for a door); '+' marks a corner. Exactly
+             one 'S' (start) must appear on the south edge and one 'F' (finish)
+             on the north edge. Lines starting with '#' are ignored everywhere.
+             Directives are optional; 'textures' defaults to the quest's usual
+             textures.
+*******************************************************************************/
+
+#ifndef LAYOUT_H_
+#define LAYOUT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Cell;
+class QuestFile;
+struct QuestFileSpawn;
+
+const char QUEST_LAYOUT_DIRECTORY[] = "quests/";
+const char QUEST_LAYOUT_EXTENSION[] = ".hq";
+const char QUEST_CACHE_EXTENSION[] = ".hqst";
+
+class QuestLayout {
+ public:
+  QuestLayout();
+  bool parse(const char *text, size_t size);
+  bool compile(const char *filename, uint64_t sourceHash) const;
+  int getWidth() const;
+  int getHeight() const;
+ private:
+  int questNo_,
+      width_,
+      height_,
+      startX_,
+      finishX_;
+  uint64_t seed_;
+  vector<int> textures_;
+  vector<Cell> cells_;
+  vector<QuestFileSpawn> spawns_;
+
+  bool parseMap(const vector<string> &lines);
+};
+
+bool openQuestLayout(const char *filename, QuestFile &file);
+string getQuestLayoutFilename(int questNo);
+
+#endif  // LAYOUT_H_
@@ -0,0 +1,660 @@
+/*******************************************************************************
+   Filename: lighting.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'MazeLighting' class, which bakes a finite
+             maze's ambient occlusion and torch light at quest load into a
+             lightmap texture.
+*******************************************************************************/
+
+#include "lighting.h"
+
+// tangent, bitangent, and normal (pointing into the cell) of each side's face
+static const float FACE_AXES[NUM_SIDES][3][3] = {
+  {{1, 0, 0}, {0, 0, 1}, {0, -1, 0}},  // NORTH
+  {{1, 0, 0}, {0, 0, 1}, {0, 1, 0}},   // SOUTH
+  {{0, 1, 0}, {0, 0, 1}, {-1, 0, 0}},  // EAST
+  {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},   // WEST
+  {{1, 0, 0}, {0, 1, 0}, {0, 0, -1}},  // TOP
+  {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}    // BOTTOM
+};
+
+//------------------------------------------------------------------------------
+//      Method: MazeLighting
+//
+// Description: Constructs an unbaked MazeLighting (see 'bake'), spreading its
+//              occlusion rays evenly over a hemisphere, more densely toward
+//              the pole (so that each ray stands for an equal share of the
+//              light falling on a face, by Lambert's cosine law).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+MazeLighting::MazeLighting() {
+  quest_ = NULL;
+  width_ = 0;
+  height_ = 0;
+  bakeTime_ = 0.0;
+  lightmap_ = 0;
+  isLightmapSupported_ = true;
+  dirtyMinX_ = dirtyMinY_ = dirtyMaxX_ = dirtyMaxY_ = 0;
+
+  double goldenAngle = PI * (3.0 - sqrt(5.0));
+  for (int i = 0; i < AMBIENT_OCCLUSION_RAYS; ++i) {
+    double u = (i + 0.5) / AMBIENT_OCCLUSION_RAYS,
+           radius = sqrt(u);
+    rays_.push_back((float) (radius * cos(i * goldenAngle)));
+    rays_.push_back((float) (radius * sin(i * goldenAngle)));
+    rays_.push_back((float) sqrt(1.0 - u));
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~MazeLighting
+//
+// Description: Destructs the MazeLighting, releasing its lightmap texture (if
+//              any).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+MazeLighting::~MazeLighting() {
+  if (lightmap_) {
+    glDeleteTextures(1, &lightmap_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: bake
+//
+// Description: Places the torches of a given quest and computes the light of
+//              every lightmap texel of every cell, splitting the rows among
+//              worker threads. The quest's walls must not change meanwhile.
+//
+//      Inputs: quest    - The (finite) quest to be lit.
+//              nThreads - Number of worker threads (0 to use all cores).
+//
+//     Outputs: The number of torches placed.
+//------------------------------------------------------------------------------
+int MazeLighting::bake(const Quest *quest, int nThreads) {
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  LightSample unlit = {255, 0};
+
+  quest_ = quest;
+  width_ = quest->getWidth();
+  height_ = quest->getHeight();
+  placeTorches();
+  samples_.assign(NUM_SIDES * width_ * height_ * LIGHTMAP_TEXELS_PER_CELL *
+                  LIGHTMAP_TEXELS_PER_CELL, unlit);
+  if (nThreads <= 0) {
+    nThreads = max(1, (int) thread::hardware_concurrency());
+  }
+
+  atomic<int> nextRow(0);
+  vector<thread> workers;
+  for (int i = 0; i < min(nThreads, height_); ++i) {
+    workers.push_back(thread(&MazeLighting::bakeRows, this, &nextRow, 0,
+                             width_, height_));
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+  bakeTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                       startTime).count();
+  markDirty(0, 0, width_, height_);
+
+  return torches_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: bakeRegion
+//
+// Description: Recomputes the light of the cells within a given rectangle on
+//              the calling thread, e.g., after a wall has been added or
+//              removed within TORCH_RADIUS of it. Torches stay where they
+//              are. The lightmap is updated by the next 'getLightmap'. Does
+//              nothing if the lighting has not been baked.
+//
+//      Inputs: minX, minY - Coordinates of the rectangle's first cell.
+//              maxX, maxY - Coordinates just beyond its last cell (clipped to
+//                           the maze).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::bakeRegion(int minX, int minY, int maxX, int maxY) {
+  if (!quest_) {
+    return;
+  }
+  minX = max(0, minX);
+  minY = max(0, minY);
+  maxX = min(width_, maxX);
+  maxY = min(height_, maxY);
+
+  atomic<int> nextRow(minY);
+  bakeRows(&nextRow, minX, maxX, maxY);
+  markDirty(minX, minY, maxX, maxY);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getLightmapCoordinates
+//
+// Description: Determines where in the lightmap (see 'getLightmap') a point on
+//              one of a cell's faces, as seen from within the cell, takes its
+//              light. Each side has its own page of the lightmap, holding
+//              LIGHTMAP_TEXELS_PER_CELL texels along each axis of each cell's
+//              face, bordered by a copy of its edge texels. Along a row of
+//              NORTH and SOUTH faces, a column of EAST and WEST faces, or
+//              anywhere across the floor or ceiling, the coordinates follow
+//              the point's world coordinates, so faces merged along those
+//              directions (see 'MazeMesh::build') are lit exactly as if drawn
+//              one cell at a time. From bottom to top of a wall, they run from
+//              the center of the cell's lowest texel to that of its highest,
+//              so that neighboring rows never blend. Faces outside the maze
+//              get ambient light only, from the unlit row at the bottom.
+//
+//      Inputs: x, y      - Coordinates of the cell of interest.
+//              side      - Integer representing the face's side (NORTH,
+//                          SOUTH, EAST, WEST, TOP, or BOTTOM).
+//              point     - World coordinates (x, y, z) of a point on the face
+//                          (e.g., a vertex of a face merged from the cell's).
+//              texCoords - Array to receive the point's (s, t) coordinates.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::getLightmapCoordinates(int x, int y, int side,
+                                          const float *point,
+                                          float *texCoords) const {
+  int n = LIGHTMAP_TEXELS_PER_CELL,
+      pageWidth = getPageWidth(),
+      pageHeight = getPageHeight();
+  float atlasWidth = 3.0f * pageWidth,
+        atlasHeight = 2.0f * pageHeight + 1.0f,
+        s = 0.5f,
+        t = atlasHeight - 0.5f;
+
+  if (x >= 0 && y >= 0 && x < width_ && y < height_) {
+    float pageS = side % 3 * pageWidth + 1.0f,
+          pageT = side / 3 * pageHeight + 1.0f;
+    s = pageS + point[0] * n;
+    t = pageT + point[1] * n;
+    if (side == NORTH || side == SOUTH) {
+      t = pageT + y * n + 0.5f + point[2] * (n - 1);
+    } else if (side == EAST || side == WEST) {
+      s = pageS + x * n + 0.5f + point[2] * (n - 1);
+    }
+  }
+  texCoords[0] = s / atlasWidth;
+  texCoords[1] = t / atlasHeight;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getLightmap
+//
+// Description: Returns the lightmap texture (see 'getLightmapCoordinates'),
+//              first creating it or uploading whatever has been baked since it
+//              was last uploaded. Must be called with a GL context current
+//              (e.g., once per frame before drawing). The lightmap is laid out
+//              as three pages across (NORTH, SOUTH, EAST, then WEST, TOP,
+//              BOTTOM) and two down, plus the unlit row.
+//
+//      Inputs: None.
+//
+//     Outputs: The lightmap's texture number, or 0 if the lighting has not
+//              been baked or the lightmap is too large for this GL.
+//------------------------------------------------------------------------------
+GLuint MazeLighting::getLightmap() {
+  if (!quest_ || !isLightmapSupported_) {
+    return 0;
+  }
+  if (!lightmap_) {
+    int atlasWidth = 3 * getPageWidth(),
+        atlasHeight = 2 * getPageHeight() + 1;
+    GLint maxSize = 0;
+    LightSample unlit = {255, 0};
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (atlasWidth > maxSize || atlasHeight > maxSize) {
+      cerr << "Error: the " << atlasWidth << "x" << atlasHeight
+           << " lightmap exceeds the maximum texture size (" << maxSize
+           << "); the maze will be drawn unlit." << endl;
+      isLightmapSupported_ = false;
+      return 0;
+    }
+    glGenTextures(1, &lightmap_);
+    glBindTexture(GL_TEXTURE_2D, lightmap_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasWidth, atlasHeight, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    texels_.assign(atlasWidth, getColor(unlit));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, atlasHeight - 1, atlasWidth, 1,
+                    GL_RGBA, GL_UNSIGNED_BYTE, &texels_[0]);
+    markDirty(0, 0, width_, height_);
+  }
+  if (dirtyMinX_ < dirtyMaxX_ && dirtyMinY_ < dirtyMaxY_) {
+    uploadLightmap();
+  }
+
+  return lightmap_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumTorches
+//
+// Description: Returns the number of torches placed by the latest 'bake'.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of torches.
+//------------------------------------------------------------------------------
+int MazeLighting::getNumTorches() const {
+  return torches_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getBakeTime
+//
+// Description: Returns how long the latest 'bake' took.
+//
+//      Inputs: None.
+//
+//     Outputs: The time taken, in seconds.
+//------------------------------------------------------------------------------
+double MazeLighting::getBakeTime() const {
+  return bakeTime_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: placeTorches
+//
+// Description: A private method that hangs a torch on a random wall of about
+//              one cell in every TORCH_SPACING, plus one on the wall of each
+//              of the start and finish doors. The choices come from a stream
+//              split off the quest's seed, so a given quest is always lit the
+//              same way, without disturbing the quest's own random choices.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::placeTorches() {
+  Random random = Random(quest_->getSeed()).split();
+
+  torches_.clear();
+  torchAt_.assign(width_ * height_, -1);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      int side = -1;
+      if (y == 0 && x == quest_->getStartX()) {
+        side = SOUTH;
+      } else if (y == height_ - 1 && x == quest_->getFinishX()) {
+        side = NORTH;
+      } else if (random.nextInt(TORCH_SPACING) == 0) {
+        int first = random.nextInt(4);
+        for (int n = 0; n < 4 && side < 0; ++n) {
+          if (quest_->hasWallAt(x, y, (first + n) % 4)) {
+            side = (first + n) % 4;
+          }
+        }
+      }
+      if (side < 0) {
+        continue;
+      }
+
+      // toward the wall from the cell's center, just short of it
+      const float *normal = FACE_AXES[side][2];
+      Torch torch = {(float) (x + 0.5 - normal[0] * (0.5 - TORCH_OFFSET)),
+                     (float) (y + 0.5 - normal[1] * (0.5 - TORCH_OFFSET)),
+                     (float) TORCH_HEIGHT};
+      torchAt_[x + y * width_] = torches_.size();
+      torches_.push_back(torch);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: bakeRows
+//
+// Description: A private method, run by each worker thread, that bakes rows
+//              of cells within a rectangle, taking the next unclaimed row
+//              each time, until none are left. The rectangle's first row is
+//              the counter's initial value.
+//
+//      Inputs: nextRow - Shared counter of the next row to be baked.
+//              minX    - Column of the rectangle's first cell.
+//              maxX    - Column just beyond its last cell.
+//              maxY    - Row just beyond its last cell.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::bakeRows(atomic<int> *nextRow, int minX, int maxX,
+                            int maxY) {
+  vector<int> nearbyTorches;
+
+  for (int y = (*nextRow)++; y < maxY; y = (*nextRow)++) {
+    for (int x = minX; x < maxX; ++x) {
+      bakeCell(x, y, nearbyTorches);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: bakeCell
+//
+// Description: A private method that computes the light of each lightmap
+//              texel of each of a cell's faces (see 'getLightmapCoordinates'),
+//              sampled at the texel's center along the floor, the ceiling, or
+//              a wall, and at the bottom and top edges up the wall. Faces
+//              where the cell has no wall are baked too, so that a wall ending
+//              beside an opening blends into light sampled where it would have
+//              continued. Each sample is taken a little way into the cell
+//              (LIGHT_SAMPLE_INSET), so that it is never on a wall that the
+//              rays test against.
+//
+//      Inputs: x, y          - Coordinates of the cell of interest.
+//              nearbyTorches - Scratch array (for the torch indices within
+//                              TORCH_RADIUS of the cell).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::bakeCell(int x, int y, vector<int> &nearbyTorches) {
+  int r = (int) ceil(TORCH_RADIUS);
+
+  nearbyTorches.clear();
+  for (int j = max(0, y - r); j <= min(height_ - 1, y + r); ++j) {
+    for (int i = max(0, x - r); i <= min(width_ - 1, x + r); ++i) {
+      if (torchAt_[i + j * width_] >= 0) {
+        nearbyTorches.push_back(torchAt_[i + j * width_]);
+      }
+    }
+  }
+  int n = LIGHTMAP_TEXELS_PER_CELL,
+      texelsX = width_ * n,
+      texelsY = height_ * n;
+  float inset = (float) LIGHT_SAMPLE_INSET;
+  for (int side = 0; side < NUM_SIDES; ++side) {
+    LightSample *samples = &samples_[side * texelsX * texelsY];
+    for (int b = 0; b < n; ++b) {
+      for (int a = 0; a < n; ++a) {
+        float point[3] = {x + (a + 0.5f) / n, y + (b + 0.5f) / n,
+                          (side == TOP) ? 1.0f - inset : inset};
+        if (side == NORTH || side == SOUTH) {
+          point[1] = (side == NORTH) ? y + 1.0f - inset : y + inset;
+          point[2] = inset + (1.0f - 2.0f * inset) * b / (n - 1);
+        } else if (side == EAST || side == WEST) {
+          point[0] = (side == EAST) ? x + 1.0f - inset : x + inset;
+          point[2] = inset + (1.0f - 2.0f * inset) * a / (n - 1);
+        }
+        LightSample &sample = samples[x * n + a + (y * n + b) * texelsX];
+        sample.ambient = (unsigned char) (getAmbientLight(point, side) *
+                                          255.0f + 0.5f);
+        sample.torch = (unsigned char) (getTorchLight(point, side,
+                                                      nearbyTorches) *
+                                        255.0f + 0.5f);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: markDirty
+//
+// Description: A private method that adds a rectangle of cells to those whose
+//              light awaits uploading (see 'getLightmap').
+//
+//      Inputs: minX, minY - Coordinates of the rectangle's first cell.
+//              maxX, maxY - Coordinates just beyond its last cell.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::markDirty(int minX, int minY, int maxX, int maxY) {
+  if (minX >= maxX || minY >= maxY) {
+    return;
+  }
+  if (dirtyMinX_ < dirtyMaxX_ && dirtyMinY_ < dirtyMaxY_) {
+    minX = min(minX, dirtyMinX_);
+    minY = min(minY, dirtyMinY_);
+    maxX = max(maxX, dirtyMaxX_);
+    maxY = max(maxY, dirtyMaxY_);
+  }
+  dirtyMinX_ = minX;
+  dirtyMinY_ = minY;
+  dirtyMaxX_ = maxX;
+  dirtyMaxY_ = maxY;
+}
+
+//------------------------------------------------------------------------------
+//      Method: uploadLightmap
+//
+// Description: A private method that converts the light of the cells marked
+//              dirty (see 'markDirty') into colors and copies them into each
+//              page of the lightmap, along with the page's border where they
+//              reach it. The lightmap must exist.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeLighting::uploadLightmap() {
+  int n = LIGHTMAP_TEXELS_PER_CELL,
+      texelsX = width_ * n,
+      texelsY = height_ * n,
+      pageWidth = getPageWidth(),
+      pageHeight = getPageHeight(),
+      minS = (dirtyMinX_ == 0) ? 0 : 1 + dirtyMinX_ * n,
+      minT = (dirtyMinY_ == 0) ? 0 : 1 + dirtyMinY_ * n,
+      maxS = (dirtyMaxX_ == width_) ? pageWidth : 1 + dirtyMaxX_ * n,
+      maxT = (dirtyMaxY_ == height_) ? pageHeight : 1 + dirtyMaxY_ * n;
+
+  texels_.resize((maxS - minS) * (maxT - minT));
+  glBindTexture(GL_TEXTURE_2D, lightmap_);
+  for (int side = 0; side < NUM_SIDES; ++side) {
+    const LightSample *samples = &samples_[side * texelsX * texelsY];
+    uint32_t *texel = &texels_[0];
+    for (int t = minT; t < maxT; ++t) {
+      int row = min(max(t - 1, 0), texelsY - 1);
+      for (int s = minS; s < maxS; ++s) {
+        *texel++ = getColor(samples[min(max(s - 1, 0), texelsX - 1) +
+                                    row * texelsX]);
+      }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, side % 3 * pageWidth + minS,
+                    side / 3 * pageHeight + minT, maxS - minS, maxT - minT,
+                    GL_RGBA, GL_UNSIGNED_BYTE, &texels_[0]);
+  }
+  dirtyMinX_ = dirtyMinY_ = dirtyMaxX_ = dirtyMaxY_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getPageWidth
+//
+// Description: A private method that returns the width of each side's page of
+//              the lightmap, including its border.
+//
+//      Inputs: None.
+//
+//     Outputs: The page's width, measured in texels.
+//------------------------------------------------------------------------------
+int MazeLighting::getPageWidth() const {
+  return width_ * LIGHTMAP_TEXELS_PER_CELL + 2;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getPageHeight
+//
+// Description: A private method that returns the height of each side's page of
+//              the lightmap, including its border.
+//
+//      Inputs: None.
+//
+//     Outputs: The page's height, measured in texels.
+//------------------------------------------------------------------------------
+int MazeLighting::getPageHeight() const {
+  return height_ * LIGHTMAP_TEXELS_PER_CELL + 2;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getColor
+//
+// Description: A private static method that converts a light sample into the
+//              color it casts on a texture.
+//
+//      Inputs: sample - The light of interest.
+//
+//     Outputs: An RGBA color (bytes in that order).
+//------------------------------------------------------------------------------
+uint32_t MazeLighting::getColor(const LightSample &sample) {
+  unsigned char rgba[4] = {0, 0, 0, 255};
+  uint32_t color;
+
+  for (int c = 0; c < 3; ++c) {
+    rgba[c] = (unsigned char) min(255.0f, sample.ambient * AMBIENT_COLOR[c] +
+                                          sample.torch * TORCH_COLOR[c] +
+                                          0.5f);
+  }
+  memcpy(&color, rgba, sizeof(color));
+
+  return color;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getAmbientLight
+//
+// Description: A private method that estimates the ambient light reaching a
+//              point on a face: each occlusion ray that hits something within
+//              AMBIENT_OCCLUSION_DISTANCE blocks a share of the light, more
+//              the nearer the hit.
+//
+//      Inputs: point - Coordinates (x, y, z) of the point of interest.
+//              side  - Integer representing the side of the face it lies on.
+//
+//     Outputs: The fraction of ambient light received, from
+//              1 - AMBIENT_OCCLUSION_STRENGTH to 1.
+//------------------------------------------------------------------------------
+float MazeLighting::getAmbientLight(const float *point, int side) const {
+  const float (*axes)[3] = FACE_AXES[side];
+  float maxDistance = (float) AMBIENT_OCCLUSION_DISTANCE,
+        occlusion = 0.0f;
+
+  for (int i = 0; i < AMBIENT_OCCLUSION_RAYS; ++i) {
+    const float *ray = &rays_[3 * i];
+    float direction[3];
+    for (int a = 0; a < 3; ++a) {
+      direction[a] = ray[0] * axes[0][a] + ray[1] * axes[1][a] +
+                     ray[2] * axes[2][a];
+    }
+    occlusion += 1.0f - trace(point, direction, maxDistance) / maxDistance;
+  }
+
+  return 1.0f - (float) AMBIENT_OCCLUSION_STRENGTH * occlusion /
+                AMBIENT_OCCLUSION_RAYS;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getTorchLight
+//
+// Description: A private method that sums the light reaching a point on a face
+//              from every torch in sight, which falls off with the cosine of
+//              its angle to the face and with the square of the fraction of
+//              TORCH_RADIUS left to travel.
+//
+//      Inputs: point         - Coordinates (x, y, z) of the point of interest.
+//              side          - Integer representing the side of the face it
+//                              lies on.
+//              nearbyTorches - Indices of the torches that might reach it.
+//
+//     Outputs: The torch light received, from 0 to 1.
+//------------------------------------------------------------------------------
+float MazeLighting::getTorchLight(const float *point, int side,
+                                  const vector<int> &nearbyTorches) const {
+  const float *normal = FACE_AXES[side][2];
+  float radius = (float) TORCH_RADIUS,
+        light = 0.0f;
+
+  for (size_t i = 0; i < nearbyTorches.size(); ++i) {
+    const Torch &torch = torches_[nearbyTorches[i]];
+    float direction[3] = {torch.x - point[0], torch.y - point[1],
+                          torch.z - point[2]},
+          distance = sqrt(direction[0] * direction[0] +
+                          direction[1] * direction[1] +
+                          direction[2] * direction[2]);
+    if (distance <= 0.0f || distance >= radius) {
+      continue;
+    }
+    for (int a = 0; a < 3; ++a) {
+      direction[a] /= distance;
+    }
+    float facing = normal[0] * direction[0] + normal[1] * direction[1] +
+                   normal[2] * direction[2];
+    if (facing <= 0.0f || trace(point, direction, distance) < distance) {
+      continue;
+    }
+    float falloff = 1.0f - distance / radius;
+    light += facing * falloff * falloff;
+  }
+
+  return min(1.0f, light);
+}
+
+//------------------------------------------------------------------------------
+//      Method: trace
+//
+// Description: A private method that follows a ray from a point within the
+//              maze, stepping from cell to cell (grid DDA) until it meets a
+//              wall, the floor, or the ceiling.
+//
+//      Inputs: origin      - Coordinates (x, y, z) of the ray's start, with z
+//                            between 0 and 1.
+//              direction   - The ray's (unit) direction.
+//              maxDistance - Distance beyond which nothing is tested.
+//
+//     Outputs: The distance to the first thing hit, or 'maxDistance' if
+//              nothing is hit before then.
+//------------------------------------------------------------------------------
+float MazeLighting::trace(const float *origin, const float *direction,
+                          float maxDistance) const {
+  const float huge = 1e30f;
+  int x = (int) origin[0],
+      y = (int) origin[1],
+      stepX = (direction[0] > 0.0f) ? 1 : -1,
+      stepY = (direction[1] > 0.0f) ? 1 : -1;
+  float distance = maxDistance,
+        deltaX = (direction[0] != 0.0f) ? fabs(1.0f / direction[0]) : huge,
+        deltaY = (direction[1] != 0.0f) ? fabs(1.0f / direction[1]) : huge,
+        nextX = ((stepX > 0) ? x + 1 - origin[0] : origin[0] - x) * deltaX,
+        nextY = ((stepY > 0) ? y + 1 - origin[1] : origin[1] - y) * deltaY;
+
+  if (direction[2] > 0.0f) {
+    distance = min(distance, (1.0f - origin[2]) / direction[2]);
+  } else if (direction[2] < 0.0f) {
+    distance = min(distance, -origin[2] / direction[2]);
+  }
+  while (true) {
+    if (nextX < nextY) {
+      if (nextX >= distance) {
+        break;
+      }
+      if (quest_->hasWallAt(x, y, (stepX > 0) ? EAST : WEST)) {
+        return nextX;
+      }
+      x += stepX;
+      nextX += deltaX;
+    } else {
+      if (nextY >= distance) {
+        break;
+      }
+      if (quest_->hasWallAt(x, y, (stepY > 0) ? NORTH : SOUTH)) {
+        return nextY;
+      }
+      y += stepY;
+      nextY += deltaY;
+    }
+  }
+
+  return distance;
+}
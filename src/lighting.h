@@ -0,0 +1,102 @@
+/*******************************************************************************
+   Filename: lighting.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'MazeLighting' class, which bakes the lighting
+             of a finite maze once, when the quest is loaded, so that it costs
+             nothing to draw. Torches are hung on walls throughout the maze
+             (and beside the start and finish doors); then, at a few points
+             on each face of each cell, as seen from within that cell, the
+             ambient light left after occlusion by nearby walls, floor, and
+             ceiling (the fraction of AMBIENT_OCCLUSION_RAYS rays, spread
+             over the hemisphere above the face, that escape) and the light
+             reaching it from every torch in sight are computed. Rows of
+             cells are spread across worker threads. The results are kept in
+             a lightmap texture, which meshes sample by world coordinates
+             (see 'getLightmapCoordinates') and which modulates their
+             textures when drawn (see 'RenderQueue').
+*******************************************************************************/
+
+#ifndef LIGHTING_H_
+#define LIGHTING_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "main.h"
+
+using namespace std;
+
+class Quest;
+
+const int AMBIENT_OCCLUSION_RAYS = 16;  // per light sample
+const double AMBIENT_OCCLUSION_DISTANCE = 1.0;  // nothing farther occludes
+const double AMBIENT_OCCLUSION_STRENGTH = 0.8;
+const int TORCH_SPACING = 12;  // about one torch per this many cells
+const double TORCH_RADIUS = 4.0;  // distance at which a torch's light ends
+const double TORCH_HEIGHT = 0.7;
+const double TORCH_OFFSET = 0.1;  // distance from the wall it hangs on
+const double LIGHT_SAMPLE_INSET = 0.02;  // from a face edge into its cell
+const int LIGHTMAP_TEXELS_PER_CELL = 2;  // along each axis of a face (>= 2)
+const float AMBIENT_COLOR[3] = {0.72f, 0.72f, 0.78f};
+const float TORCH_COLOR[3] = {1.0f, 0.66f, 0.32f};
+
+// The light reaching one point of a face, from 0 (none) to 255 (full).
+struct LightSample {
+  unsigned char ambient,
+                torch;
+};
+
+struct Torch {
+  float x,
+        y,
+        z;
+};
+
+class MazeLighting {
+ public:
+  MazeLighting();
+  ~MazeLighting();
+  int bake(const Quest *quest, int nThreads = 0);
+  void bakeRegion(int minX, int minY, int maxX, int maxY);
+  void getLightmapCoordinates(int x, int y, int side, const float *point,
+                              float *texCoords) const;
+  GLuint getLightmap();
+  int getNumTorches() const;
+  double getBakeTime() const;
+ private:
+  const Quest *quest_;
+  int width_,
+      height_;
+  vector<Torch> torches_;
+  vector<int> torchAt_;  // per cell, index of the torch it holds (or -1)
+  vector<LightSample> samples_;  // per side, one texel grid (see bakeCell)
+  vector<float> rays_;  // (x, y, z) of each ray, about the +z axis
+  double bakeTime_;
+  GLuint lightmap_;
+  bool isLightmapSupported_;
+  int dirtyMinX_,  // cells whose samples have changed since the last upload
+      dirtyMinY_,
+      dirtyMaxX_,  // exclusive
+      dirtyMaxY_;  // exclusive
+  vector<uint32_t> texels_;  // staging area for uploads
+
+  void placeTorches();
+  void bakeRows(atomic<int> *nextRow, int minX, int maxX, int maxY);
+  void bakeCell(int x, int y, vector<int> &nearbyTorches);
+  void markDirty(int minX, int minY, int maxX, int maxY);
+  void uploadLightmap();
+  int getPageWidth() const;
+  int getPageHeight() const;
+  static uint32_t getColor(const LightSample &sample);
+  float getAmbientLight(const float *point, int side) const;
+  float getTorchLight(const float *point, int side,
+                      const vector<int> &nearbyTorches) const;
+  float trace(const float *origin, const float *direction,
+              float maxDistance) const;
+};
+
+#endif  // LIGHTING_H_
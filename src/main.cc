@@ -9,9 +9,11 @@ Description: Main file for "HeroQuest 3D," a simple 3D action-adventure game
 *******************************************************************************/
 
 #include "main.h"
+#include "simulation.h"
+#include "raycaster.h"
+#include "recorder.h"
 
 const int NUM_QUESTS = 3;
-const int NUM_TEXTURES = 12;
 
 double screenX = 1200;
 double screenY = 600;
@@ -24,13 +26,31 @@ double VR = screenX;
 double VB = 0;
 double VT = screenY;
 int gQuestNum = 1;
+uint64_t gSeed = DEFAULT_SEED;
+bool gInfinite = false;
+int gNumNpcs = 0;  // extra NPCs added to every quest
+char *gQuestFilename = NULL;
+char *gRecordFilename = NULL;  // video recorded to this file, if any
 bool gPerspectiveKeyDown = false;
+bool gOverlayKeyDown = false;
+bool gShowOverlay = true;
+bool gHeadless = false;  // rendering offscreen, with no window (or GLUT)
+bool gRaycast = false;  // first-person view drawn by the software raycaster
 bool gLeftButtonDown = false;
 bool gMiddleButtonDown = false;
 bool gRightButtonDown = false;
+gliGenericImage *gImages[NUM_TEXTURES];
 GLuint gTextures[NUM_TEXTURES];
+GLuint gTextureArray = 0;
 Quest *gQuest = NULL;
 Character *gPlayer = NULL;
+Minimap *gMinimap = NULL;
+Simulation *gSimulation = NULL;
+ResolutionScaler *gScaler = NULL;
+Raycaster *gRaycaster = NULL;
+FrameRecorder *gRecorder = NULL;
+double gTargetFrameRate = DEFAULT_TARGET_FRAME_RATE;  // 0 for full resolution
+Snapshot gFrame;  // the state drawn by the current frame
 
 //------------------------------------------------------------------------------
 //      Method: readTgaImage
@@ -198,6 +218,55 @@ int getTextureNo(int i) {
   return gTextures[i];
 }
 
+//------------------------------------------------------------------------------
+//      Method: getTextureArray
+//
+// Description: Returns the texture holding every texture as one layer of a
+//              single 3D texture (layer i is texture index i, as passed to
+//              'getTextureNo'), so that faces of different materials can be
+//              drawn without rebinding.
+//
+//      Inputs: None.
+//
+//     Outputs: The 3D texture's number, or 0 if it could not be created.
+//------------------------------------------------------------------------------
+int getTextureArray() {
+  return gTextureArray;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getTextureImage
+//
+// Description: Returns the image from which a given texture was created (see
+//              'readTextures'), for renderers that read texels directly.
+//
+//      Inputs: i - Index of the desired texture.
+//
+//     Outputs: A pointer to the texture's image, or NULL if the index is
+//              invalid or the textures have not been read.
+//------------------------------------------------------------------------------
+gliGenericImage *getTextureImage(int i) {
+  if (i < 0 || i >= NUM_TEXTURES) {
+    return NULL;
+  }
+
+  return gImages[i];
+}
+
+//------------------------------------------------------------------------------
+//      Method: getQuestSeed
+//
+// Description: Returns the seed used to generate a given quest, derived from
+//              the session seed so that a whole campaign can be replayed.
+//
+//      Inputs: questNo - Integer representing a specific quest.
+//
+//     Outputs: The quest's seed.
+//------------------------------------------------------------------------------
+uint64_t getQuestSeed(int questNo) {
+  return gSeed + questNo - 1;
+}
+
 //------------------------------------------------------------------------------
 // Functions that draw basic primitives.
 //------------------------------------------------------------------------------
@@ -244,6 +313,9 @@ void drawText(double x, double y, char *string) {
   int len, i;
   void *font = GLUT_BITMAP_9_BY_15;
 
+  if (gHeadless) {
+    return;  // GLUT's fonts require glutInit, hence a display
+  }
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   glEnable(GL_BLEND);
   glRasterPos2d(x, y);
@@ -254,46 +326,265 @@ void drawText(double x, double y, char *string) {
   glDisable(GL_BLEND);
 }
 
+//------------------------------------------------------------------------------
+//      Method: drawOverlay
+//
+// Description: Draws rendering statistics (chunks drawn and culled by the
+//              view frustum, and the scale at which the 3D scene is drawn) in
+//              the lower-left corner of the window and the minimap of explored
+//              cells, if any, in the upper-right corner.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void drawOverlay() {
+  char text[128];
+
+  snprintf(text, sizeof(text),
+           "chunks: %d visible, %d culled  resolution: %d%%",
+           gQuest->getNumVisibleChunks(), gQuest->getNumCulledChunks(),
+           (int) ((gScaler ? gScaler->getScale() : 1.0) * 100.0 + 0.5));
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  gluOrtho2D(0, screenX, 0, screenY);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+  glDisable(GL_DEPTH_TEST);
+  glColor3d(1.0, 1.0, 1.0);
+  drawText(10, 10, text);
+  if (gMinimap) {
+    gMinimap->draw(screenX - MINIMAP_SIZE - 10, screenY - MINIMAP_SIZE - 10,
+                   MINIMAP_SIZE);
+  }
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glMatrixMode(GL_MODELVIEW);
+}
+
+//------------------------------------------------------------------------------
+//      Method: bakeQuestLighting
+//
+// Description: Bakes a newly created quest's lighting (see 'MazeLighting')
+//              and reports how long it took.
+//
+//      Inputs: quest - The quest to be lit.
+//
+//     Outputs: The same quest.
+//------------------------------------------------------------------------------
+Quest *bakeQuestLighting(Quest *quest) {
+  int nTorches = quest->bakeLighting();
+
+  cout << "Baked lighting (" << nTorches << " torches) in "
+       << quest->getLighting()->getBakeTime() * 1000.0 << " ms" << endl;
+
+  return quest;
+}
+
+//------------------------------------------------------------------------------
+//      Method: createQuest
+//
+// Description: Creates a given campaign quest. If a layout definition exists
+//              for it (see 'getQuestLayoutFilename'), the quest is loaded from
+//              that layout's compiled cache; otherwise a random maze is
+//              generated. Either way, its lighting is then baked.
+//
+//      Inputs: questNo     - Integer representing a specific quest.
+//              perspective - Integer representing the desired perspective.
+//
+//     Outputs: A pointer to the newly created quest.
+//------------------------------------------------------------------------------
+Quest *createQuest(int questNo, int perspective) {
+  string filename = getQuestLayoutFilename(questNo);
+  FILE *layout = fopen(filename.c_str(), "rb");
+
+  if (layout) {
+    fclose(layout);
+    QuestFile file;
+    if (openQuestLayout(filename.c_str(), file)) {
+      return bakeQuestLighting(new Quest(file, perspective));
+    }
+  }
+
+  return bakeQuestLighting(new Quest(questNo, DEFAULT_MAZE_WIDTH,
+                                     DEFAULT_MAZE_HEIGHT, perspective,
+                                     getQuestSeed(questNo)));
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawRaycastFrame
+//
+// Description: Renders the first-person view of the current frame in software
+//              (see 'Raycaster'), at the size of the current viewport, and
+//              copies it into the framebuffer currently bound.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void drawRaycastFrame() {
+  GLint viewport[4];
+
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  if (!gRaycaster) {
+    gRaycaster = new Raycaster();
+  }
+  gRaycaster->render(gQuest, gFrame, viewport[2], viewport[3]);
+  glPushAttrib(GL_ENABLE_BIT);
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_TEXTURE_3D);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, gRaycaster->getStride());
+  glWindowPos2i(viewport[0], viewport[1]);
+  glDrawPixels(gRaycaster->getWidth(), gRaycaster->getHeight(), GL_RGBA,
+               GL_UNSIGNED_BYTE, gRaycaster->getPixels());
+  glPopClientAttrib();
+  glPopAttrib();
+}
+
+//------------------------------------------------------------------------------
+//      Method: renderFrame
+//
+// Description: Draws the latest simulated state (never waiting for the
+//              simulation), along with the overlay, into the framebuffer
+//              currently bound: the window's, or an offscreen one when
+//              rendering headlessly. Unless disabled, the 3D scene is drawn at
+//              whatever resolution holds the target frame rate and then
+//              stretched to the full size, while the overlay is always drawn
+//              at full resolution (see 'ResolutionScaler'). If requested
+//              ("--raycast"), a finite quest's first-person view is drawn by
+//              the software raycaster instead of OpenGL.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void renderFrame() {
+  gSimulation->getFrame(gFrame);
+  const CrowdInstance &player = gFrame.player;
+  double eyeZ = player.z + player.height / 1.5,
+         angle = player.rotation * PI / 180.0;
+  if (!gScaler && gTargetFrameRate > 0.0) {
+    gScaler = new ResolutionScaler(1.0 / gTargetFrameRate);
+  }
+  if (gScaler) {
+    gScaler->begin(screenX, screenY);
+  }
+  if (gRaycast && gQuest->getPerspective() == FIRST_PERSON &&
+      !gQuest->isInfinite()) {
+    drawRaycastFrame();
+  } else {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glLoadIdentity();
+    if (gQuest->getPerspective() == FIRST_PERSON) {
+      gluLookAt(player.x,
+                player.y,
+                eyeZ,
+                player.x + cos(angle),
+                player.y + sin(angle),
+                eyeZ,
+                0.0,
+                0.0,
+                1.0);
+    } else if (gQuest->isInfinite()) {  // overhead view following the player
+      gluLookAt(player.x,
+                player.y - DEFAULT_MAZE_HEIGHT,
+                DEFAULT_MAZE_WIDTH + DEFAULT_MAZE_HEIGHT,
+                player.x,
+                player.y,
+                0.0,
+                0.0,
+                0.0,
+                1.0);
+    } else if (gQuest->getPerspective() == THIRD_PERSON) {
+      gluLookAt(DEFAULT_MAZE_WIDTH / 2.0 - 0.25,
+                -DEFAULT_MAZE_HEIGHT / 2.0 - 0.35,
+                DEFAULT_MAZE_WIDTH + DEFAULT_MAZE_HEIGHT,
+                DEFAULT_MAZE_WIDTH / 2.0 - 0.25,
+                DEFAULT_MAZE_HEIGHT / 2.0 - 0.35,
+                0.0,
+                0.0,
+                0.0,
+                1.0);
+    }
+
+    // draw quest environment and game characters
+    gQuest->draw(gFrame);
+  }
+  if (gScaler) {
+    gScaler->end();
+  }
+  if (!gQuest->isInfinite()) {
+    if (!gMinimap) {
+      gMinimap = new Minimap(gQuest);
+    }
+    gMinimap->update((int) player.x, (int) player.y);
+  }
+  if (gShowOverlay) {
+    drawOverlay();
+  }
+}
+
 //------------------------------------------------------------------------------
 // GLUT callback functions.
 //------------------------------------------------------------------------------
 
 void display(void) {
-  // check for level completion
-  if (isKeyPressed('e') &&
-      gPlayer->getNextX() > gQuest->getFinishX() &&
-      gPlayer->getNextX() < (gQuest->getFinishX() + 1.0) &&
-      gPlayer->getNextY() > (gQuest->getHeight() - 2.0)) {
-    int perspective = gQuest->getPerspective();
+  // check for level completion (detected by the simulation)
+  if (gSimulation->isQuestComplete()) {
+    int perspective = gQuest->getPerspective(),
+        playerType = gPlayer->getType();
     gQuestNum++;
     if (gQuestNum > NUM_QUESTS) {
       gQuestNum = 1;
     }
+    delete gSimulation;
     if (gPlayer) {
       delete gPlayer;
     }
     if (gQuest) {
       delete gQuest;
     }
-    gQuest = new Quest(gQuestNum, DEFAULT_MAZE_WIDTH, DEFAULT_MAZE_HEIGHT);
-    gPlayer = new Character(gPlayer->getType(), gQuest);
+    if (gMinimap) {
+      delete gMinimap;
+      gMinimap = NULL;
+    }
+    gQuest = createQuest(gQuestNum, perspective);
+    gQuest->addCharacters(gNumNpcs);
+    gPlayer = new Character(playerType, gQuest);
     gQuest->setPlayer(gPlayer);
     gQuest->setPerspective(perspective);
+    gSimulation = new Simulation(gQuest, gPlayer);
+    gSimulation->start();
   }
 
-  // check for gravity effects
-  if (gPlayer->isOnGround() == false) {
-    gPlayer->fall();
-  }
-
-  // check for user input
+  // check for user input (movement is handled by the simulation)
   if (isKeyPressed(KEY_ESCAPE)) {
+    if (gRecorder) {
+      delete gRecorder;  // finishes the video
+    }
+    delete gSimulation;
     if (gQuest) {
       delete gQuest;
     }
     if (gPlayer) {
       delete gPlayer;
     }
+    if (gMinimap) {
+      delete gMinimap;
+    }
+    if (gScaler) {
+      delete gScaler;
+    }
+    if (gRaycaster) {
+      delete gRaycaster;
+    }
     exit(0);
   }
   if (isKeyPressed('p') || isKeyPressed('r')) {
@@ -307,60 +598,17 @@ void display(void) {
     }
     reshape(screenX, screenY);
   }
-  if (isKeyPressed(KEY_SPACE) && gPlayer->isOnGround()) {
-    gPlayer->jump();
-  }
-  if (isKeyPressed(KEY_UP) || isKeyPressed('w')) {
-    gPlayer->moveForward();
-  }
-  if (isKeyPressed(KEY_DOWN) || isKeyPressed('s')) {
-    gPlayer->moveBackward();
-  }
-  if (isKeyPressed('z')) {
-    gPlayer->strafeLeft();
+  if (isKeyPressed('o')) {
+    gOverlayKeyDown = true;
+  } else if (gOverlayKeyDown) {
+    gOverlayKeyDown = false;
+    gShowOverlay = !gShowOverlay;
   }
-  if (isKeyPressed('c')) {
-    gPlayer->strafeRight();
-  }
-  if (isKeyPressed(KEY_LEFT) || isKeyPressed('a')) {
-    gPlayer->rotateLeft();
-  }
-  if (isKeyPressed(KEY_RIGHT) || isKeyPressed('d')) {
-    gPlayer->rotateRight();
-  }
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glEnable(GL_DEPTH_TEST);
-  glLoadIdentity();
-  if (gQuest->getPerspective() == FIRST_PERSON) {
-    gluLookAt(gPlayer->getX(),
-              gPlayer->getY(),
-              gPlayer->getZ() + gPlayer->getHeight() / 1.5,
-              gPlayer->getNextX(),
-              gPlayer->getNextY(),
-              gPlayer->getNextZ() + gPlayer->getHeight() / 1.5,
-              0.0,
-              0.0,
-              1.0);
-  } else if (gQuest->getPerspective() == THIRD_PERSON) {
-    gluLookAt(DEFAULT_MAZE_WIDTH / 2.0 - 0.25,
-              -DEFAULT_MAZE_HEIGHT / 2.0 - 0.35,
-              DEFAULT_MAZE_WIDTH + DEFAULT_MAZE_HEIGHT,
-              DEFAULT_MAZE_WIDTH / 2.0 - 0.25,
-              DEFAULT_MAZE_HEIGHT / 2.0 - 0.35,
-              0.0,
-              0.0,
-              0.0,
-              1.0);
-  }
-
-  // draw quest environment
-  gQuest->draw();
 
-  // draw game characters
-  if (gQuest->getPerspective() != FIRST_PERSON) {
-    gPlayer->draw();
+  renderFrame();
+  if (gRecorder) {
+    gRecorder->capture(screenX, screenY);
   }
-
   glutSwapBuffers();
   glutPostRedisplay();
 }
@@ -441,9 +689,47 @@ void mouse(int mouse_button, int state, int px, int py) {
   glutPostRedisplay();
 }
 
-void initializeMyStuff() {
-  // initialize textures
-  gliGenericImage *image[NUM_TEXTURES];
+//------------------------------------------------------------------------------
+//      Method: loadQuest
+//
+// Description: Creates a quest from a quest file (see questfile.h), reports
+//              how long loading took, and bakes the quest's lighting.
+//
+//      Inputs: filename - Path of the quest file.
+//
+//     Outputs: A pointer to the newly created quest, or NULL if the file could
+//              not be loaded.
+//------------------------------------------------------------------------------
+Quest *loadQuest(char *filename) {
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  QuestFile file;
+  if (!file.open(filename)) {
+    return NULL;
+  }
+  Quest *quest = new Quest(file);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            startTime).count();
+  gQuestNum = quest->getQuestNo();
+  cout << "Loaded " << quest->getWidth() << "x" << quest->getHeight()
+       << " quest from " << filename << " in " << seconds * 1000.0 << " ms"
+       << endl;
+
+  return bakeQuestLighting(quest);
+}
+
+//------------------------------------------------------------------------------
+//      Method: readTextures
+//
+// Description: Reads every texture's image from its file. The images are kept
+//              for the life of the program (see 'getTextureImage'). Exits if
+//              any texture is missing.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void readTextures() {
+  gliGenericImage **image = gImages;
   int n = 0;
 
     // Quest 1:
@@ -470,13 +756,19 @@ void initializeMyStuff() {
     cin.get();
     exit(1);
   }
+}
+
+void initializeMyStuff() {
+  // initialize textures
+  gliGenericImage **image = gImages;
 
+  readTextures();
   glGenTextures(NUM_TEXTURES, gTextures);
 
   for(int i = 0; i < NUM_TEXTURES; ++i) {
     glBindTexture(GL_TEXTURE_2D, gTextures[i]);
     glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-    bool repeats = false,
+    bool repeats = true,  // merged maze faces tile their textures
          needsBorder = false;  // true if clamping, not filling whole polygon
 
     if (repeats) {
@@ -510,16 +802,464 @@ void initializeMyStuff() {
     }
   }
 
-  // initialize quest and player character
-  gQuest = new Quest(gQuestNum, DEFAULT_MAZE_WIDTH, DEFAULT_MAZE_HEIGHT);
+  // pack every texture, rescaled to a common size, into the layers of one 3D
+  // texture (no mipmaps, since those would blend neighboring layers)
+  vector<unsigned char> layer(TEXTURE_ARRAY_SIZE * TEXTURE_ARRAY_SIZE * 4);
+  while (glGetError() != GL_NO_ERROR) {}  // clear earlier errors
+  glGenTextures(1, &gTextureArray);
+  glBindTexture(GL_TEXTURE_3D, gTextureArray);
+  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+  glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, TEXTURE_ARRAY_SIZE,
+               TEXTURE_ARRAY_SIZE, NUM_TEXTURES, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               NULL);
+  for (int i = 0; i < NUM_TEXTURES; ++i) {
+    gluScaleImage(image[i]->format, image[i]->width, image[i]->height,
+                  GL_UNSIGNED_BYTE, image[i]->pixels, TEXTURE_ARRAY_SIZE,
+                  TEXTURE_ARRAY_SIZE, GL_UNSIGNED_BYTE, &layer[0]);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, i, TEXTURE_ARRAY_SIZE,
+                    TEXTURE_ARRAY_SIZE, 1, image[i]->format, GL_UNSIGNED_BYTE,
+                    &layer[0]);
+  }
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (glGetError() != GL_NO_ERROR) {
+    glDeleteTextures(1, &gTextureArray);
+    gTextureArray = 0;  // draw with the separate textures instead
+  }
+
+  // initialize quest (loaded from a file, if one was given) and player
+  if (gQuestFilename) {
+    gQuest = loadQuest(gQuestFilename);
+  }
+  if (!gQuest) {
+    gQuest = createQuest(gQuestNum, DEFAULT_PERSPECTIVE);
+  }
+  gQuest->addCharacters(gNumNpcs);
+  if (gInfinite) {
+    gQuest->makeInfinite(DEFAULT_VIEW_DISTANCE);
+  }
   gPlayer = new Character(PLAYER_BARBARIAN, gQuest);
   gQuest->setPlayer(gPlayer);
+  gSimulation = new Simulation(gQuest, gPlayer);
+  gSimulation->start();
+
+  // start recording, if requested
+  if (gRecordFilename && !gRecorder) {
+    gRecorder = new FrameRecorder();
+    if (!gRecorder->start(gRecordFilename)) {
+      delete gRecorder;
+      gRecorder = NULL;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: generateMaze
+//
+// Description: Generates a single quest of a given size without opening a
+//              window and reports maze generation throughput. Intended for
+//              measuring generator performance on very large mazes.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//              nThreads      - Number of generation threads (0 to decide
+//                              automatically).
+//
+//     Outputs: 0 if successful, 1 if the dimensions are invalid.
+//------------------------------------------------------------------------------
+int generateMaze(int width, int height, int nThreads) {
+  if (width <= 0 || height <= 0) {
+    cerr << "Error: invalid maze size " << width << "x" << height << "."
+         << endl;
+    return 1;
+  }
+
+  Quest *quest = new Quest(gQuestNum, width, height, DEFAULT_PERSPECTIVE,
+                           getQuestSeed(gQuestNum), nThreads);
+  cout << "Generated " << width << "x" << height << " maze: "
+       << (long long) quest->getGenerationRate() << " cells/s" << endl;
+  delete quest;
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: saveQuest
+//
+// Description: Generates a single quest of a given size without opening a
+//              window and saves it to a quest file (see questfile.h), which
+//              can then be played with "--load-quest".
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//              filename      - Path of the output file.
+//
+//     Outputs: 0 if successful, 1 if an error occurs.
+//------------------------------------------------------------------------------
+int saveQuest(int width, int height, char *filename) {
+  if (width <= 0 || height <= 0) {
+    cerr << "Error: invalid maze size " << width << "x" << height << "."
+         << endl;
+    return 1;
+  }
+
+  Quest *quest = new Quest(gQuestNum, width, height, DEFAULT_PERSPECTIVE,
+                           getQuestSeed(gQuestNum));
+  int result = quest->save(filename);
+  delete quest;
+  if (result < 0) {
+    cerr << "Error: could not write \"" << filename << "\"." << endl;
+    return 1;
+  }
+  cout << "Saved " << width << "x" << height << " quest to " << filename
+       << endl;
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: streamMaze
+//
+// Description: Generates a maze of a given size one row at a time and writes
+//              each row to a quest file (see questfile.h) as soon as it is
+//              produced, so memory use depends only on the maze's width. The
+//              file has no NPC spawns. Reports throughput in cells per second.
+//
+//      Inputs: width, height - Maze dimensions, measured in cells.
+//              filename      - Path of the output file.
+//
+//     Outputs: 0 if successful, 1 if an error occurs.
+//------------------------------------------------------------------------------
+int streamMaze(int width, int height, char *filename) {
+  if (width <= 0 || height <= 0) {
+    cerr << "Error: invalid maze size " << width << "x" << height << "."
+         << endl;
+    return 1;
+  }
+
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  Random random(getQuestSeed(gQuestNum));
+  EllerGenerator rows(width, height, random.split());
+  QuestFileHeader header;
+  QuestFileWriter writer;
+  vector<Cell> row(width);
+  initializeQuestFileHeader(header, width, height, 0);
+  header.questNo = gQuestNum;
+  header.startX = random.nextInt(width);
+  header.finishX = random.nextInt(width);
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    header.textures[m] = TEXTURE_OFFSET_PER_QUEST * (gQuestNum - 1) + m;
+  }
+  header.seed = getQuestSeed(gQuestNum);
+  if (!writer.open(filename, header)) {
+    return 1;
+  }
+  while (rows.nextRow(&row[0]) >= 0) {
+    if (!writer.writeRow(&row[0])) {
+      cerr << "Error: could not write \"" << filename << "\"." << endl;
+      return 1;
+    }
+  }
+  if (!writer.finish(NULL)) {
+    cerr << "Error: could not write \"" << filename << "\"." << endl;
+    return 1;
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            startTime).count();
+  cout << "Streamed " << width << "x" << height << " maze to " << filename
+       << ": " << (long long) (width * (double) height / seconds)
+       << " cells/s" << endl;
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: runRenderBenchmark
+//
+// Description: Renders a given number of frames of the current quest (see
+//              'renderFrame') into an offscreen framebuffer, with no window or
+//              display (see 'HeadlessContext'), and reports each frame's CPU
+//              time (to submit the frame), GPU time (to execute it, via a
+//              timer query if supported), and total time (until the frame is
+//              finished), followed by their averages. One untimed frame is
+//              rendered first, so that one-time setup (shaders, meshes) is not
+//              counted. Runs on a machine with no GPU by way of a software
+//              renderer such as Mesa's llvmpipe, whose GPU times cover little
+//              more than command processing; its total times are the ones to
+//              watch. The simulation runs meanwhile, as in the game, as does
+//              dynamic resolution scaling unless disabled ("--target-fps 0");
+//              each frame's resolution scale is reported as well. If recording
+//              ("--record"), the time taken to capture each finished frame
+//              (included in its total time) is reported too.
+//
+//      Inputs: nFrames       - Number of frames to render.
+//              width, height - Framebuffer size, in pixels.
+//
+//     Outputs: 0 if successful, 1 if an error occurs.
+//------------------------------------------------------------------------------
+int runRenderBenchmark(int nFrames, int width, int height) {
+  HeadlessContext context;
+  GLuint query = 0;
+  GLint counterBits = 0;
+  double totalCpuTime = 0.0,
+         totalGpuTime = 0.0,
+         totalTime = 0.0,
+         totalCaptureTime = 0.0;
+
+  if (nFrames <= 0 || width <= 0 || height <= 0) {
+    cerr << "Error: invalid render benchmark of " << nFrames << " frames at "
+         << width << "x" << height << "." << endl;
+    return 1;
+  }
+  if (!context.create(width, height)) {
+    return 1;
+  }
+  gHeadless = true;
+  glColor3d(0.0, 0.0, 0.0);
+  glClearColor(0.0, 0.0, 0.0, 0.0);
+  initializeMyStuff();
+  reshape(width, height);
+  renderFrame();
+  glFinish();
+
+  // GPU times require timer queries (OpenGL 3.3)
+  while (glGetError() != GL_NO_ERROR) {}  // clear earlier errors
+  glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &counterBits);
+  if (glGetError() == GL_NO_ERROR && counterBits > 0) {
+    glGenQueries(1, &query);
+  }
+  cout << "Render benchmark: " << width << "x" << height << " on "
+       << context.getRenderer() << endl;
+  for (int i = 0; i < nFrames; ++i) {
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    GLuint64 gpuTime = 0;
+    double captureTime = 0.0;
+    if (query) {
+      glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+    renderFrame();
+    if (query) {
+      glEndQuery(GL_TIME_ELAPSED);
+    }
+    double cpuTime = chrono::duration<double>(chrono::steady_clock::now() -
+                                              startTime).count();
+    glFinish();
+
+    // captured once finished, as swapping would wait for the frame anyway
+    if (gRecorder) {
+      chrono::steady_clock::time_point captureStartTime =
+        chrono::steady_clock::now();
+      gRecorder->capture(width, height);
+      captureTime = chrono::duration<double>(chrono::steady_clock::now() -
+                                             captureStartTime).count();
+    }
+    double time = chrono::duration<double>(chrono::steady_clock::now() -
+                                           startTime).count();
+    cout << "  frame " << i << ": cpu " << cpuTime * 1000.0 << " ms, gpu ";
+    if (query) {
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuTime);
+      cout << gpuTime / 1e6 << " ms";
+    } else {
+      cout << "n/a";
+    }
+    cout << ", total " << time * 1000.0 << " ms, scale "
+         << (gScaler ? gScaler->getScale() : 1.0);
+    if (gRecorder) {
+      cout << ", capture " << captureTime * 1000.0 << " ms";
+    }
+    cout << endl;
+    totalCpuTime += cpuTime;
+    totalGpuTime += gpuTime / 1e9;
+    totalTime += time;
+    totalCaptureTime += captureTime;
+  }
+  cout << "  average: cpu " << totalCpuTime * 1000.0 / nFrames << " ms, gpu ";
+  if (query) {
+    cout << totalGpuTime * 1000.0 / nFrames << " ms";
+  } else {
+    cout << "n/a";
+  }
+  cout << ", total " << totalTime * 1000.0 / nFrames << " ms ("
+       << nFrames / totalTime << " frames/s)";
+  if (gRecorder) {
+    cout << ", capture " << totalCaptureTime * 1000.0 / nFrames << " ms";
+  }
+  cout << endl;
+
+  if (query) {
+    glDeleteQueries(1, &query);
+  }
+  delete gRecorder;
+  gRecorder = NULL;
+  delete gSimulation;
+  gSimulation = NULL;
+  delete gMinimap;
+  gMinimap = NULL;
+  delete gScaler;
+  gScaler = NULL;
+  delete gQuest;
+  gQuest = NULL;
+  delete gPlayer;
+  gPlayer = NULL;
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: runRaycastBenchmark
+//
+// Description: Renders a given number of first-person frames of the current
+//              (finite) quest with the software raycaster alone, with no
+//              window or OpenGL context at all, and reports each frame's time
+//              followed by the average. The simulation runs meanwhile, as in
+//              the game. The last frame may be saved as a PPM image, e.g., as
+//              a reference for comparison with the OpenGL renderer.
+//
+//      Inputs: nFrames       - Number of frames to render.
+//              width, height - Frame size, in pixels.
+//              filename      - Path of the image file, or NULL for none.
+//
+//     Outputs: 0 if successful, 1 if an error occurs.
+//------------------------------------------------------------------------------
+int runRaycastBenchmark(int nFrames, int width, int height,
+                        const char *filename) {
+  Raycaster raycaster;
+  double totalTime = 0.0;
+  int result = 0;
+
+  if (nFrames <= 0 || width <= 0 || height <= 0) {
+    cerr << "Error: invalid raycast benchmark of " << nFrames
+         << " frames at " << width << "x" << height << "." << endl;
+    return 1;
+  }
+  if (gInfinite) {
+    cerr << "Error: the raycaster cannot render infinite quests." << endl;
+    return 1;
+  }
+  readTextures();
+  if (gQuestFilename) {
+    gQuest = loadQuest(gQuestFilename);
+  }
+  if (!gQuest) {
+    gQuest = createQuest(gQuestNum, FIRST_PERSON);
+  }
+  gQuest->addCharacters(gNumNpcs);
+  gPlayer = new Character(PLAYER_BARBARIAN, gQuest);
+  gQuest->setPlayer(gPlayer);
+  gSimulation = new Simulation(gQuest, gPlayer);
+  gSimulation->start();
+
+  cout << "Raycast benchmark: " << width << "x" << height << " on "
+       << max(1, (int) thread::hardware_concurrency()) << " threads" << endl;
+  for (int i = 0; i < nFrames; ++i) {
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    gSimulation->getFrame(gFrame);
+    raycaster.render(gQuest, gFrame, width, height);
+    double time = chrono::duration<double>(chrono::steady_clock::now() -
+                                           startTime).count();
+    cout << "  frame " << i << ": " << time * 1000.0 << " ms" << endl;
+    totalTime += time;
+  }
+  cout << "  average: " << totalTime * 1000.0 / nFrames << " ms ("
+       << nFrames / totalTime << " frames/s)" << endl;
+  if (filename) {
+    result = raycaster.save(filename);
+    if (result == 0) {
+      cout << "Saved the last frame to " << filename << endl;
+    }
+  }
+
+  delete gSimulation;
+  gSimulation = NULL;
+  delete gQuest;
+  gQuest = NULL;
+  delete gPlayer;
+  gPlayer = NULL;
+
+  return result;
 }
 
 int main(int argc, char **argv) {
   bool fullscreen = false;
 
-  srand(time(0));
+  // an explicit seed makes every quest (and benchmark) reproducible
+  gSeed = time(0);
+  if (argc >= 3 && strcmp(argv[1], "--seed") == 0) {
+    gSeed = strtoull(argv[2], NULL, 10);
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
+  cout << "Seed: " << gSeed << endl;
+  if (argc >= 2 && strcmp(argv[1], "--infinite") == 0) {
+    gInfinite = true;
+    argv[1] = argv[0];
+    --argc;
+    ++argv;
+  }
+  if (argc >= 3 && strcmp(argv[1], "--npcs") == 0) {
+    gNumNpcs = atoi(argv[2]);
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc >= 3 && strcmp(argv[1], "--target-fps") == 0) {
+    gTargetFrameRate = atof(argv[2]);
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc >= 2 && strcmp(argv[1], "--raycast") == 0) {
+    gRaycast = true;
+    argv[1] = argv[0];
+    --argc;
+    ++argv;
+  }
+  if (argc >= 3 && strcmp(argv[1], "--record") == 0) {
+    gRecordFilename = argv[2];
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc >= 3 && strcmp(argv[1], "--load-quest") == 0) {
+    gQuestFilename = argv[2];
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
+  if ((argc == 4 || argc == 5) && strcmp(argv[1], "--generate") == 0) {
+    return generateMaze(atoi(argv[2]), atoi(argv[3]),
+                        argc == 5 ? atoi(argv[4]) : 0);
+  }
+  if (argc == 5 && strcmp(argv[1], "--stream-maze") == 0) {
+    return streamMaze(atoi(argv[2]), atoi(argv[3]), argv[4]);
+  }
+  if (argc == 5 && strcmp(argv[1], "--save-quest") == 0) {
+    return saveQuest(atoi(argv[2]), atoi(argv[3]), argv[4]);
+  }
+  if ((argc == 6 || argc == 7) && strcmp(argv[1], "--farm") == 0) {
+    return runQuestFarm(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), argv[5],
+                        getQuestSeed(gQuestNum), argc == 7 ? atoi(argv[6]) : 0);
+  }
+  if (argc == 4 && strcmp(argv[1], "--bench-grid") == 0) {
+    return runGridBenchmark(atoi(argv[2]), atoi(argv[3]));
+  }
+  if (argc == 4 && strcmp(argv[1], "--bench-path") == 0) {
+    return runPathBenchmark(atoi(argv[2]), atoi(argv[3]));
+  }
+  if ((argc == 3 || argc == 5) && strcmp(argv[1], "--bench-render") == 0) {
+    return runRenderBenchmark(atoi(argv[2]),
+                              argc == 5 ? atoi(argv[3]) : screenX,
+                              argc == 5 ? atoi(argv[4]) : screenY);
+  }
+  if ((argc == 3 || argc == 5 || argc == 6) &&
+      strcmp(argv[1], "--bench-raycast") == 0) {
+    return runRaycastBenchmark(atoi(argv[2]),
+                               argc >= 5 ? atoi(argv[3]) : screenX,
+                               argc >= 5 ? atoi(argv[4]) : screenY,
+                               argc == 6 ? argv[5] : NULL);
+  }
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
   glutInitWindowSize(screenX, screenY);
@@ -538,6 +1278,10 @@ int main(int argc, char **argv) {
   glClearColor(0.0, 0.0, 0.0, 0.0);  // background color
   initializeMyStuff();
   glutMainLoop();
+  if (gSimulation) {
+    delete gSimulation;
+    gSimulation = NULL;
+  }
   if (gQuest) {
     delete gQuest;
     gQuest = NULL;
@@ -16,15 +16,25 @@ Description: Main header file for "HeroQuest 3D," a simple 3D action-adventure
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // buffer objects (OpenGL 1.5)
+#endif
 #include <GL/glut.h>
 #include "tga.h"
 #include "keys.h"
 #include "quest.h"
 #include "character.h"
+#include "benchmark.h"
+#include "farm.h"
+#include "layout.h"
+#include "headless.h"
+#include "resolution.h"
 
 using namespace std;
 
 const double PI = 4.0 * atan(1.0);
+const int NUM_TEXTURES = 12;
+const int TEXTURE_ARRAY_SIZE = 256;  // texels per side of each array layer
 
 void drawCircle(double x1, double y1, double radius);
 void drawRectangle(double x1, double y1, double x2, double y2);
@@ -33,7 +43,11 @@ void drawTriangle(double x1, double y1,
                   double x3, double y3);
 void drawLine(double x1, double x2, double y1, double y2);
 void drawText(double x, double y, char *string);
+void drawOverlay();
+void renderFrame();
 void reshape(int w, int h);
 int getTextureNo(int i);
+int getTextureArray();
+gliGenericImage *getTextureImage(int i);
 
 #endif  // MAIN_H_
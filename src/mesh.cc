@@ -0,0 +1,418 @@
+/*******************************************************************************
+   Filename: mesh.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'MazeMesh' class, which bakes the static faces
+             of a rectangular block of cells into a single vertex buffer
+             object (VBO), grouped by material.
+*******************************************************************************/
+
+#include <cstddef>
+#include "mesh.h"
+#include "lighting.h"
+
+// NORTH and WEST faces look into the cell, SOUTH and EAST faces out of it, and
+// TOP and BOTTOM faces up
+const float FACE_CORNERS[NUM_SIDES][4][3] = {
+  {{0, 1, 0}, {1, 1, 0}, {1, 1, 1}, {0, 1, 1}},  // NORTH
+  {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}},  // SOUTH
+  {{1, 0, 0}, {1, 1, 0}, {1, 1, 1}, {1, 0, 1}},  // EAST
+  {{0, 0, 0}, {0, 1, 0}, {0, 1, 1}, {0, 0, 1}},  // WEST
+  {{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}},  // TOP
+  {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}   // BOTTOM
+};
+
+//------------------------------------------------------------------------------
+//      Method: MazeMesh
+//
+// Description: Constructs an empty MazeMesh (see 'build').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+MazeMesh::MazeMesh() {
+  buffer_ = 0;
+  isUploaded_ = false;
+  isTwoSided_ = false;
+  minX_ = minY_ = maxX_ = maxY_ = 0;
+  first_.assign(NUM_MATERIALS, 0);
+  count_.assign(NUM_MATERIALS, 0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~MazeMesh
+//
+// Description: Destructs the MazeMesh, releasing its vertex buffer (if any).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+MazeMesh::~MazeMesh() {
+  if (buffer_) {
+    glDeleteBuffers(1, &buffer_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: build
+//
+// Description: Generates the mesh's faces from a block of cells (every NORTH
+//              and EAST wall, plus SOUTH and WEST walls along the outer edges
+//              of the maze, the ceiling, and the floor), merging coplanar
+//              faces of the same material into maximal rectangles (see
+//              'mergeFaces') and sorting them by material into one array of
+//              vertices. When lit, each wall is emitted once for each cell
+//              beside it, facing that cell and sampling that cell's light
+//              from the lightmap (see 'MazeLighting::getLightmapCoordinates'),
+//              so that back-face culling shows each side with its own light
+//              and light never shows through a wall; since the lightmap
+//              follows world coordinates, lighting never keeps faces from
+//              merging. No GL calls are made, so this may be done without a
+//              GL context; the array is uploaded on the next 'bind'.
+//
+//      Inputs: cells            - The block's first cell.
+//              stride           - Number of cells between vertically adjacent
+//                                 cells in the 'cells' array.
+//              width, height    - Block dimensions, measured in cells.
+//              originX, originY - World coordinates of the block's first cell.
+//              layers           - Array of NUM_MATERIALS texture array layers
+//                                 (see 'getTextureArray'), one per material,
+//                                 stored with each face's vertices.
+//              startX           - World x-coordinate of the cell whose SOUTH
+//                                 wall at y = 0 is the start door (or -1).
+//              finishX, finishY - World coordinates of the cell whose NORTH
+//                                 wall is the finish door (or -1).
+//              mask             - Array indexed like 'cells' (same stride)
+//                                 whose nonzero entries select the cells to be
+//                                 included, or NULL to include every cell.
+//                                 SOUTH and WEST walls of an included cell are
+//                                 then kept wherever the neighbor sharing them
+//                                 is excluded, so the mask must also cover the
+//                                 cells just south and west of the block
+//                                 (e.g., a mask of the whole maze).
+//              lighting         - The maze's baked lighting (see
+//                                 'MazeLighting'), or NULL to leave every
+//                                 face unlit, with one face per wall that
+//                                 must be drawn without culling.
+//
+//     Outputs: The number of faces (merged rectangles) generated.
+//------------------------------------------------------------------------------
+int MazeMesh::build(const Cell *cells, int stride, int width, int height,
+                    int originX, int originY, const int *layers, int startX,
+                    int finishX, int finishY, const unsigned char *mask,
+                    const MazeLighting *lighting) {
+  // ceilings go last, so that they can be left off the end of a draw call
+  static const int order[NUM_MATERIALS] = {WALL_MATERIAL, DOOR_MATERIAL,
+                                           FLOOR_MATERIAL, CEILING_MATERIAL};
+  vector<MeshVertex> faces[NUM_MATERIALS];
+  vector<int> materials(width * height),
+              backs;
+
+  for (int side = 0; side < NUM_SIDES; ++side) {
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        int x = originX + i,
+            y = originY + j;
+        int &material = materials[i + j * width];
+
+        material = -1;
+        if (!cells[i + j * stride].hasWallAt(side) ||
+            (mask && !mask[i + j * stride])) {
+          continue;
+        } else if (side == NORTH) {
+          material = (x == finishX && y == finishY) ? DOOR_MATERIAL :
+                                                      WALL_MATERIAL;
+        } else if (side == SOUTH) {
+          if (y == 0) {
+            material = (x == startX) ? DOOR_MATERIAL : WALL_MATERIAL;
+          } else if (mask && !mask[i + (j - 1) * stride]) {
+            material = WALL_MATERIAL;
+          }
+        } else if (side == WEST) {
+          if (x == 0 || (mask && !mask[i - 1 + j * stride])) {
+            material = WALL_MATERIAL;
+          }
+        } else if (side == EAST) {
+          material = WALL_MATERIAL;
+        } else {
+          material = (side == TOP) ? CEILING_MATERIAL : FLOOR_MATERIAL;
+        }
+      }
+    }
+    if (lighting && side != TOP && side != BOTTOM) {
+      backs = materials;
+      mergeFaces(faces, side, true, backs, layers, width, height, originX,
+                 originY, lighting);
+    }
+    mergeFaces(faces, side, false, materials, layers, width, height, originX,
+               originY, lighting);
+  }
+
+  vertices_.clear();
+  for (int i = 0; i < NUM_MATERIALS; ++i) {
+    int m = order[i];
+    first_[m] = vertices_.size();
+    count_[m] = faces[m].size();
+    vertices_.insert(vertices_.end(), faces[m].begin(), faces[m].end());
+  }
+  isUploaded_ = false;
+  isTwoSided_ = lighting != NULL;
+  minX_ = originX;
+  minY_ = originY;
+  maxX_ = originX + width;
+  maxY_ = originY + height;
+
+  return getNumFaces();
+}
+
+//------------------------------------------------------------------------------
+//      Method: clear
+//
+// Description: Removes all of the mesh's faces.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::clear() {
+  vertices_.clear();
+  first_.assign(NUM_MATERIALS, 0);
+  count_.assign(NUM_MATERIALS, 0);
+  isUploaded_ = false;
+}
+
+//------------------------------------------------------------------------------
+//      Method: bind
+//
+// Description: Makes the mesh's vertex buffer the source of vertex and texture
+//              coordinate arrays (the lightmap's on texture unit 1),
+//              uploading its vertices to the GPU first if they have changed.
+//              The caller must have enabled GL_VERTEX_ARRAY and
+//              GL_TEXTURE_COORD_ARRAY (on unit 1 too, if lit), as well as
+//              GL_CULL_FACE if the mesh is two-sided (see 'isTwoSided').
+//
+//      Inputs: isLayered - 'true' if drawing with the texture array, in which
+//                          case each vertex's layer is passed as its third
+//                          texture coordinate.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::bind(bool isLayered) {
+  if (!buffer_) {
+    glGenBuffers(1, &buffer_);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  if (!isUploaded_) {
+    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(MeshVertex),
+                 vertices_.empty() ? NULL : &vertices_[0], GL_STATIC_DRAW);
+    vector<MeshVertex>().swap(vertices_);  // the GPU holds the only copy now
+    isUploaded_ = true;
+  }
+  glTexCoordPointer(isLayered ? 3 : 2, GL_FLOAT, sizeof(MeshVertex),
+                    (const GLvoid *) offsetof(MeshVertex, s));
+  glClientActiveTexture(GL_TEXTURE1);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex),
+                    (const GLvoid *) offsetof(MeshVertex, lightS));
+  glClientActiveTexture(GL_TEXTURE0);
+  glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex),
+                  (const GLvoid *) offsetof(MeshVertex, x));
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawMaterial
+//
+// Description: Draws all of the mesh's faces of a given material with a single
+//              call, using whatever texture is currently bound. The mesh must
+//              be bound (see 'bind').
+//
+//      Inputs: material - Index of the material of interest.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::drawMaterial(int material) const {
+  if (count_[material] > 0) {
+    glDrawArrays(GL_QUADS, first_[material], count_[material]);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawAll
+//
+// Description: Draws all of the mesh's faces with a single call, which
+//              requires the texture array to be bound (see 'bind'). Ceilings
+//              are drawn only in first-person perspective.
+//
+//      Inputs: perspective - Integer representing the current perspective.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::drawAll(int perspective) const {
+  int nVertices = first_[CEILING_MATERIAL];
+
+  if (perspective == FIRST_PERSON) {
+    nVertices += count_[CEILING_MATERIAL];
+  }
+  if (nVertices > 0) {
+    glDrawArrays(GL_QUADS, 0, nVertices);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumFaces
+//
+// Description: Returns the number of faces in the mesh.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of faces (quads).
+//------------------------------------------------------------------------------
+int MazeMesh::getNumFaces() const {
+  int nVertices = 0;
+
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    nVertices += count_[m];
+  }
+
+  return nVertices / 4;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumVertices
+//
+// Description: Returns the number of vertices of the mesh's faces of a given
+//              material.
+//
+//      Inputs: material - Index of the material of interest.
+//
+//     Outputs: The number of vertices (four per face).
+//------------------------------------------------------------------------------
+int MazeMesh::getNumVertices(int material) const {
+  return count_[material];
+}
+
+//------------------------------------------------------------------------------
+//      Method: mergeFaces
+//
+// Description: A private static method that greedily covers the faces on one
+//              side of a block of cells with as few rectangles as possible:
+//              starting from each uncovered face, a run of faces of the same
+//              material is extended as far as possible along the first axis,
+//              then the whole run is extended along the second axis. Walls
+//              are merged only along their own plane (NORTH and SOUTH walls
+//              along a row, EAST and WEST walls along a column); floors and
+//              ceilings are merged in both directions.
+//
+//      Inputs: faces            - Array of NUM_MATERIALS vertex arrays to be
+//                                 appended to.
+//              side             - Integer representing the side of interest.
+//              isBack           - 'true' to emit the backs of the faces (see
+//                                 'addFace').
+//              materials        - Material of each cell's face on that side
+//                                 (-1 if it has none); cleared as faces are
+//                                 covered.
+//              layers           - Texture array layer of each material.
+//              width, height    - Block dimensions, measured in cells.
+//              originX, originY - World coordinates of the block's first cell.
+//              lighting         - The maze's baked lighting (or NULL).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::mergeFaces(vector<MeshVertex> *faces, int side, bool isBack,
+                          vector<int> &materials, const int *layers,
+                          int width, int height, int originX, int originY,
+                          const MazeLighting *lighting) {
+  for (int j = 0; j < height; ++j) {
+    for (int i = 0; i < width; ++i) {
+      int material = materials[i + j * width],
+          w = 1,
+          h = 1;
+      if (material < 0) {
+        continue;
+      }
+      if (side != EAST && side != WEST) {
+        while (i + w < width && materials[i + w + j * width] == material) {
+          ++w;
+        }
+      }
+      if (side != NORTH && side != SOUTH) {
+        bool canGrow = true;
+        while (canGrow && j + h < height) {
+          for (int k = i; k < i + w && canGrow; ++k) {
+            canGrow = materials[k + (j + h) * width] == material;
+          }
+          if (canGrow) {
+            ++h;
+          }
+        }
+      }
+      for (int n = j; n < j + h; ++n) {
+        for (int k = i; k < i + w; ++k) {
+          materials[k + n * width] = -1;
+        }
+      }
+      addFace(faces[material], side, isBack, originX + i, originY + j, w, h,
+              layers[material], lighting);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: addFace
+//
+// Description: A private static method that appends the four vertices of a
+//              face spanning a rectangle of cells, with texture coordinates
+//              that repeat the texture once per cell (textures must therefore
+//              use GL_REPEAT wrapping). When lit, the face is wound to face
+//              the cell whose light it takes: the rectangle's own cells for
+//              its front, or the cells across the wall for its back.
+//
+//      Inputs: vertices - The array to be appended to.
+//              side     - Integer representing the face's side (NORTH, SOUTH,
+//                         EAST, WEST, TOP, or BOTTOM).
+//              isBack   - 'true' for the back of a wall.
+//              x, y     - World coordinates of the rectangle's first cell.
+//              w, h     - Rectangle dimensions, measured in cells (h is 1 for
+//                         NORTH and SOUTH faces, w is 1 for EAST and WEST).
+//              layer    - The face's texture array layer.
+//              lighting - The maze's baked lighting (or NULL).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void MazeMesh::addFace(vector<MeshVertex> &vertices, int side, bool isBack,
+                       int x, int y, int w, int h, int layer,
+                       const MazeLighting *lighting) {
+  const float (*corners)[3] = FACE_CORNERS[side];
+  static const float texCoords[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  float s = (side == EAST || side == WEST) ? h : w,
+        t = (side == TOP || side == BOTTOM) ? h : 1;
+  int lightX = x,
+      lightY = y,
+      lightSide = side;
+  bool isReversed = false;
+
+  if (lighting) {
+    isReversed = (side == NORTH || side == WEST || side == BOTTOM) == isBack;
+  }
+  if (isBack) {
+    lightX += (side == EAST) - (side == WEST);
+    lightY += (side == NORTH) - (side == SOUTH);
+    lightSide = oppositeSide(side);
+  }
+  for (int n = 0; n < 4; ++n) {
+    int k = isReversed ? 3 - n : n;
+    float point[3] = {x + corners[k][0] * w, y + corners[k][1] * h,
+                      corners[k][2]},
+          lightCoords[2] = {0.0f, 0.0f};
+    if (lighting) {
+      lighting->getLightmapCoordinates(lightX, lightY, lightSide, point,
+                                       lightCoords);
+    }
+    MeshVertex vertex = {texCoords[k][0] * s, texCoords[k][1] * t,
+                         (float) layer, lightCoords[0], lightCoords[1],
+                         point[0], point[1], point[2]};
+    vertices.push_back(vertex);
+  }
+}
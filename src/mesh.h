@@ -0,0 +1,90 @@
+/*******************************************************************************
+   Filename: mesh.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'MazeMesh' class, which bakes the static faces
+             of a rectangular block of cells into a single vertex buffer
+             object (VBO), grouped by material and tagged with each material's
+             texture array layer, so that the whole block can be drawn with
+             one call (or one call per material, when no texture array is
+             available; see 'RenderQueue'). When the maze is lit, each side
+             of a wall is a face of its own, facing the cell it belongs to, and
+             each vertex also carries its coordinates in the lightmap (see
+             'MazeLighting').
+*******************************************************************************/
+
+#ifndef MESH_H_
+#define MESH_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Cell;
+class MazeLighting;
+
+const int MESH_BLOCK_SIZE = 32;  // cells per side of each Quest mesh block
+
+// Corners of each side's face as (x, y, z) offsets from the cell's origin,
+// counterclockwise as seen from the front (see mesh.cc), indexed by side.
+extern const float FACE_CORNERS[][4][3];
+
+// One interleaved vertex: texture coordinates (r being the texture array
+// layer), lightmap coordinates, then position.
+struct MeshVertex {
+  float s,
+        t,
+        r,
+        lightS,
+        lightT,
+        x,
+        y,
+        z;
+};
+
+class MazeMesh {
+ public:
+  MazeMesh();
+  ~MazeMesh();
+  int build(const Cell *cells, int stride, int width, int height,
+            int originX, int originY, const int *layers, int startX = -1,
+            int finishX = -1, int finishY = -1,
+            const unsigned char *mask = NULL,
+            const MazeLighting *lighting = NULL);
+  void clear();
+  void bind(bool isLayered);
+  void drawMaterial(int material) const;
+  void drawAll(int perspective) const;
+  int getNumFaces() const;
+  int getNumVertices(int material) const;
+  bool isTwoSided() const { return isTwoSided_; }
+  int getMinX() const { return minX_; }
+  int getMinY() const { return minY_; }
+  int getMaxX() const { return maxX_; }
+  int getMaxY() const { return maxY_; }
+  double getCenterX() const { return (minX_ + maxX_) / 2.0; }
+  double getCenterY() const { return (minY_ + maxY_) / 2.0; }
+ private:
+  GLuint buffer_;
+  bool isUploaded_,
+       isTwoSided_;  // each side of a wall is a face of its own
+  int minX_,  // bounds of the block, measured in cells
+      minY_,
+      maxX_,  // exclusive
+      maxY_;  // exclusive
+  vector<int> first_,  // first vertex of each material's faces
+              count_;  // number of vertices of each material's faces
+  vector<MeshVertex> vertices_;
+
+  static void mergeFaces(vector<MeshVertex> *faces, int side, bool isBack,
+                         vector<int> &materials, const int *layers,
+                         int width, int height, int originX, int originY,
+                         const MazeLighting *lighting);
+  static void addFace(vector<MeshVertex> &vertices, int side, bool isBack,
+                      int x, int y, int w, int h, int layer,
+                      const MazeLighting *lighting);
+};
+
+#endif  // MESH_H_
@@ -0,0 +1,274 @@
+/*******************************************************************************
+   Filename: minimap.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Minimap' class, which shows the cells explored
+             by the player around the player's position.
+*******************************************************************************/
+
+#include <cstdlib>
+#include "minimap.h"
+
+// luminance/alpha texel values
+static const unsigned char OUTSIDE_TEXEL[2] = {0, 0},
+                           FOG_TEXEL[2] = {0, 128},
+                           FLOOR_TEXEL[2] = {220, 255},
+                           WALL_TEXEL[2] = {60, 255};
+
+//------------------------------------------------------------------------------
+//      Method: wrap
+//
+// Description: A static helper that maps a cell coordinate to its position in
+//              the minimap's toroidally addressed texture.
+//
+//      Inputs: coordinate - A cell coordinate (possibly negative).
+//
+//     Outputs: The coordinate modulo MINIMAP_CELLS, in [0, MINIMAP_CELLS).
+//------------------------------------------------------------------------------
+static int wrap(int coordinate) {
+  int result = coordinate % MINIMAP_CELLS;
+
+  return result < 0 ? result + MINIMAP_CELLS : result;
+}
+
+//------------------------------------------------------------------------------
+//      Method: Minimap
+//
+// Description: Constructs a Minimap for a given quest. Its texture is created
+//              on the first 'update'.
+//
+//      Inputs: quest - The quest whose explored cells are to be shown.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Minimap::Minimap(Quest *quest) {
+  quest_ = quest;
+  texture_ = 0;
+  centerX_ = 0;
+  centerY_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~Minimap
+//
+// Description: Destructs the Minimap, releasing its texture.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Minimap::~Minimap() {
+  if (texture_) {
+    glDeleteTextures(1, &texture_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: update
+//
+// Description: Marks the player's cell as explored and brings the texture up
+//              to date: the whole map is uploaded only the first time;
+//              afterward, moving to another cell uploads just the rows and
+//              columns of cells scrolling into view (the texture wraps
+//              around, so nothing already uploaded moves), and exploring a
+//              cell uploads just that cell's texels.
+//
+//      Inputs: x, y - Coordinates of the player's cell.
+//
+//     Outputs: The number of texels uploaded.
+//------------------------------------------------------------------------------
+int Minimap::update(int x, int y) {
+  int half = MINIMAP_CELLS / 2,
+      dx = x - centerX_,
+      dy = y - centerY_,
+      nTexels = 0;
+  bool isNew = quest_->explore(x, y);
+
+  if (!texture_ || abs(dx) >= MINIMAP_CELLS || abs(dy) >= MINIMAP_CELLS) {
+    if (!texture_) {
+      glGenTextures(1, &texture_);
+      glBindTexture(GL_TEXTURE_2D, texture_);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, MINIMAP_TEXELS,
+                   MINIMAP_TEXELS, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,
+                   NULL);
+    }
+    centerX_ = x;
+    centerY_ = y;
+    return uploadCells(x - half, y - half, x + half, y + half);
+  }
+  if (dx > 0) {
+    nTexels += uploadCells(centerX_ + half, y - half, x + half, y + half);
+  } else if (dx < 0) {
+    nTexels += uploadCells(x - half, y - half, centerX_ - half, y + half);
+  }
+  if (dy > 0) {
+    nTexels += uploadCells(x - half, centerY_ + half, x + half, y + half);
+  } else if (dy < 0) {
+    nTexels += uploadCells(x - half, y - half, x + half, centerY_ - half);
+  }
+  centerX_ = x;
+  centerY_ = y;
+  if (isNew) {
+    nTexels += uploadCells(x, y, x + 1, y + 1);
+  }
+
+  return nTexels;
+}
+
+//------------------------------------------------------------------------------
+//      Method: draw
+//
+// Description: Draws the minimap as a square, with the player's cell marked at
+//              its center, in the current (pixel) coordinates. Its luminance-
+//              alpha texture is drawn with GL_MODULATE (GL_DECAL, the usual
+//              mode, is undefined for that format), then GL_DECAL is restored.
+//
+//      Inputs: left, bottom - Position of the minimap's lower-left corner.
+//              size         - Length of the minimap's sides.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Minimap::draw(double left, double bottom, double size) const {
+  int half = MINIMAP_CELLS / 2;
+  double s = (double) (centerX_ - half) / MINIMAP_CELLS,
+         t = (double) (centerY_ - half) / MINIMAP_CELLS,
+         cellSize = size / MINIMAP_CELLS;
+
+  if (!texture_) {
+    return;
+  }
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+  glColor3d(1.0, 1.0, 1.0);
+  glBegin(GL_QUADS);
+  glTexCoord2d(s, t);
+  glVertex2d(left, bottom);
+  glTexCoord2d(s + 1.0, t);
+  glVertex2d(left + size, bottom);
+  glTexCoord2d(s + 1.0, t + 1.0);
+  glVertex2d(left + size, bottom + size);
+  glTexCoord2d(s, t + 1.0);
+  glVertex2d(left, bottom + size);
+  glEnd();
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+  glDisable(GL_TEXTURE_2D);
+
+  // mark the player's cell
+  left += half * cellSize;
+  bottom += half * cellSize;
+  glColor3d(1.0, 0.0, 0.0);
+  glBegin(GL_QUADS);
+  glVertex2d(left, bottom);
+  glVertex2d(left + cellSize / 2.0, bottom);
+  glVertex2d(left + cellSize / 2.0, bottom + cellSize / 2.0);
+  glVertex2d(left, bottom + cellSize / 2.0);
+  glEnd();
+  glDisable(GL_BLEND);
+}
+
+//------------------------------------------------------------------------------
+//      Method: uploadCells
+//
+// Description: A private method that uploads the texels of a rectangle of
+//              cells (at most MINIMAP_CELLS on a side), split into at most four
+//              blocks where it wraps around the texture's edges.
+//
+//      Inputs: minX, minY - The rectangle's minimum corner (inclusive).
+//              maxX, maxY - The rectangle's maximum corner (exclusive).
+//
+//     Outputs: The number of texels uploaded.
+//------------------------------------------------------------------------------
+int Minimap::uploadCells(int minX, int minY, int maxX, int maxY) {
+  int nTexels = 0;
+
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  for (int x = minX; x < maxX;) {
+    int endX = min(maxX, x + MINIMAP_CELLS - wrap(x));
+    for (int y = minY; y < maxY;) {
+      int endY = min(maxY, y + MINIMAP_CELLS - wrap(y));
+      nTexels += uploadBlock(x, y, endX, endY);
+      y = endY;
+    }
+    x = endX;
+  }
+
+  return nTexels;
+}
+
+//------------------------------------------------------------------------------
+//      Method: uploadBlock
+//
+// Description: A private method that uploads the texels of a rectangle of
+//              cells that does not wrap around the texture's edges.
+//
+//      Inputs: minX, minY - The rectangle's minimum corner (inclusive).
+//              maxX, maxY - The rectangle's maximum corner (exclusive).
+//
+//     Outputs: The number of texels uploaded.
+//------------------------------------------------------------------------------
+int Minimap::uploadBlock(int minX, int minY, int maxX, int maxY) {
+  int width = 2 * (maxX - minX),
+      height = 2 * (maxY - minY),
+      stride = 2 * width;  // bytes per row of texels
+
+  texels_.resize(stride * height);
+  for (int y = minY; y < maxY; ++y) {
+    for (int x = minX; x < maxX; ++x) {
+      getCellTexels(x, y, &texels_[2 * (y - minY) * stride + 4 * (x - minX)],
+                    stride);
+    }
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 2 * wrap(minX), 2 * wrap(minY), width,
+                  height, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, &texels_[0]);
+
+  return width * height;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCellTexels
+//
+// Description: A private method that writes the 2 x 2 texels representing a
+//              given cell: its floor and the passages east (bottom row) and
+//              north (top row) of it, which are shown only once the cell has
+//              been explored, and a corner post.
+//
+//      Inputs: x, y   - Coordinates of the cell.
+//              texels - Destination of the cell's lower-left texel.
+//              stride - Number of bytes per row of texels.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Minimap::getCellTexels(int x, int y, unsigned char *texels,
+                            int stride) const {
+  const unsigned char *floor = OUTSIDE_TEXEL,
+                      *east = OUTSIDE_TEXEL,
+                      *north = OUTSIDE_TEXEL,
+                      *corner = OUTSIDE_TEXEL;
+
+  if (quest_->getCellIndex(x, y) >= 0) {
+    if (quest_->isExplored(x, y)) {
+      floor = FLOOR_TEXEL;
+      east = quest_->hasWallAt(x, y, EAST) ? WALL_TEXEL : FLOOR_TEXEL;
+      north = quest_->hasWallAt(x, y, NORTH) ? WALL_TEXEL : FLOOR_TEXEL;
+      corner = WALL_TEXEL;
+    } else {
+      floor = east = north = corner = FOG_TEXEL;
+    }
+  }
+  texels[0] = floor[0];
+  texels[1] = floor[1];
+  texels[2] = east[0];
+  texels[3] = east[1];
+  texels[stride] = north[0];
+  texels[stride + 1] = north[1];
+  texels[stride + 2] = corner[0];
+  texels[stride + 3] = corner[1];
+}
@@ -0,0 +1,48 @@
+/*******************************************************************************
+   Filename: minimap.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Minimap' class, which shows the cells explored
+             by the player around the player's position. The map is kept in a
+             small texture of MINIMAP_CELLS x MINIMAP_CELLS cells (2 x 2 texels
+             apiece: the floor, the passages north and east, and a corner
+             post) addressed toroidally, so that as the player moves only the
+             row or column of cells scrolling into view is uploaded, and a
+             newly explored cell costs a single 2 x 2 upload. Frames in which
+             the player stays in the same cell cost no uploads at all.
+*******************************************************************************/
+
+#ifndef MINIMAP_H_
+#define MINIMAP_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Quest;
+
+const int MINIMAP_CELLS = 64;  // cells per side, centered on the player
+const int MINIMAP_TEXELS = 2 * MINIMAP_CELLS;
+const int MINIMAP_SIZE = 192;  // pixels per side on screen
+
+class Minimap {
+ public:
+  Minimap(Quest *quest);
+  ~Minimap();
+  int update(int x, int y);
+  void draw(double left, double bottom, double size) const;
+ private:
+  Quest *quest_;
+  GLuint texture_;
+  int centerX_,
+      centerY_;
+  vector<unsigned char> texels_;  // staging area for uploads
+
+  int uploadCells(int minX, int minY, int maxX, int maxY);
+  int uploadBlock(int minX, int minY, int maxX, int maxY);
+  void getCellTexels(int x, int y, unsigned char *texels, int stride) const;
+};
+
+#endif  // MINIMAP_H_
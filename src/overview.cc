@@ -0,0 +1,160 @@
+/*******************************************************************************
+   Filename: overview.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of an 'OverviewCache' class, which caches a rendering
+             of the static maze for the third-person camera.
+*******************************************************************************/
+
+#include <cstring>
+#include "overview.h"
+
+//------------------------------------------------------------------------------
+//      Method: OverviewCache
+//
+// Description: Constructs an empty OverviewCache. Its framebuffer is created on
+//              the first 'begin'.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+OverviewCache::OverviewCache() {
+  target_ = 0;
+  isValid_ = false;
+  isSupported_ = true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isCurrent
+//
+// Description: Determines whether the cached image may be used as is: it must
+//              have been rendered since the last 'invalidate', at the current
+//              viewport size, and with the current projection and modelview
+//              matrices.
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if the cache is current.
+//------------------------------------------------------------------------------
+bool OverviewCache::isCurrent() const {
+  GLint viewport[4];
+  double projection[16],
+         modelview[16];
+
+  if (!isValid_) {
+    return false;
+  }
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetDoublev(GL_PROJECTION_MATRIX, projection);
+  glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+
+  return viewport[2] == framebuffer_.getWidth() &&
+         viewport[3] == framebuffer_.getHeight() &&
+         memcmp(projection, projection_, sizeof(projection)) == 0 &&
+         memcmp(modelview, modelview_, sizeof(modelview)) == 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: begin
+//
+// Description: Prepares to render the maze into the cache: the framebuffer is
+//              (re)created at the viewport's size if necessary, bound, and
+//              cleared, and the current matrices are recorded, as is the
+//              framebuffer currently drawn to (the window's, or an offscreen
+//              one). The caller then draws the maze and calls 'end'.
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if the cache is ready to be drawn into, 'false'
+//              if offscreen rendering is unavailable (the maze must then be
+//              drawn directly).
+//------------------------------------------------------------------------------
+bool OverviewCache::begin() {
+  GLint viewport[4];
+
+  isValid_ = false;
+  if (!isSupported_) {
+    return false;
+  }
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target_);
+  if (!framebuffer_.resize(viewport[2], viewport[3])) {
+    isSupported_ = false;
+    return false;
+  }
+  glGetDoublev(GL_PROJECTION_MATRIX, projection_);
+  glGetDoublev(GL_MODELVIEW_MATRIX, modelview_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_.getId());
+  glViewport(0, 0, viewport[2], viewport[3]);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: end
+//
+// Description: Finishes rendering into the cache, which becomes current, and
+//              restores drawing to the framebuffer recorded by 'begin'.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void OverviewCache::end() {
+  glBindFramebuffer(GL_FRAMEBUFFER, target_);
+  isValid_ = true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: blit
+//
+// Description: Copies the cached color and depth images to the framebuffer
+//              currently drawn to, so that characters drawn afterward are
+//              hidden behind walls as usual. If the copy fails (e.g., the
+//              window's depth format differs from the cache's), the cache is
+//              disabled for good.
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if the cached image now fills the window, 'false'
+//              if the maze must be drawn directly instead.
+//------------------------------------------------------------------------------
+bool OverviewCache::blit() {
+  if (!isValid_) {
+    return false;
+  }
+  while (glGetError() != GL_NO_ERROR) {}  // clear stale errors
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target_);
+  int width = framebuffer_.getWidth(),
+      height = framebuffer_.getHeight();
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_.getId());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                    GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, target_);
+  if (glGetError() != GL_NO_ERROR) {
+    framebuffer_.release();
+    isValid_ = false;
+    isSupported_ = false;
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: invalidate
+//
+// Description: Marks the cached image as out of date (e.g., because a wall has
+//              changed), so that the maze is rendered again.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void OverviewCache::invalidate() {
+  isValid_ = false;
+}
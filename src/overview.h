@@ -0,0 +1,38 @@
+/*******************************************************************************
+   Filename: overview.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of an 'OverviewCache' class, which holds a rendering
+             of the static maze as seen from the fixed third-person camera in
+             an offscreen framebuffer (color and depth). Each frame the cached
+             image is copied to the window in one blit, after which only the
+             characters need to be drawn; the maze is re-rendered only when
+             the cache is invalidated (e.g., a wall changes) or the viewport or
+             camera matrices differ from those it was rendered with.
+*******************************************************************************/
+
+#ifndef OVERVIEW_H_
+#define OVERVIEW_H_
+
+#include "quest.h"
+#include "framebuffer.h"
+
+class OverviewCache {
+ public:
+  OverviewCache();
+  bool isCurrent() const;
+  bool begin();
+  void end();
+  bool blit();
+  void invalidate();
+ private:
+  Framebuffer framebuffer_;  // the size of the viewport
+  GLint target_;  // the framebuffer drawn to before 'begin' (0 for a window)
+  bool isValid_,
+       isSupported_;
+  double projection_[16],  // the matrices the cache was rendered with
+         modelview_[16];
+};
+
+#endif  // OVERVIEW_H_
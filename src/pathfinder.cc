@@ -0,0 +1,622 @@
+/*******************************************************************************
+   Filename: pathfinder.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Pathfinder' class, which answers shortest-path
+             queries over a quest's maze using a two-level hierarchy (HPA*) of
+             per-cluster junction graphs and an abstract graph of cluster
+             entrances.
+*******************************************************************************/
+
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include "pathfinder.h"
+
+//------------------------------------------------------------------------------
+//      Method: Pathfinder
+//
+// Description: Constructs a Pathfinder for a given quest, preprocessing every
+//              cluster (see 'buildCluster'). The quest's walls are read, never
+//              modified; after changing them, call 'update'.
+//
+//      Inputs: quest       - The quest whose maze is to be searched.
+//              clusterSize - Number of cells per side of each cluster.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Pathfinder::Pathfinder(const Quest *quest, int clusterSize) {
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  int width = quest->getWidth(),
+      height = quest->getHeight();
+
+  quest_ = quest;
+  clusterSize_ = max(1, clusterSize);
+  clustersX_ = (width + clusterSize_ - 1) / clusterSize_;
+  clustersY_ = (height + clusterSize_ - 1) / clusterSize_;
+  nNodes_ = 0;
+  searchNo_ = 0;
+  clusters_.resize(clustersX_ * clustersY_);
+  junctionOfCell_.assign(width * height, -1);
+  nodeOfCell_.assign(width * height, -1);
+  for (int c = 0; c < clusters_.size(); ++c) {
+    clusters_[c].minX = (c % clustersX_) * clusterSize_;
+    clusters_[c].minY = (c / clustersX_) * clusterSize_;
+    clusters_[c].maxX = min(width, clusters_[c].minX + clusterSize_);
+    clusters_[c].maxY = min(height, clusters_[c].minY + clusterSize_);
+    buildCluster(c);
+  }
+  buildTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                        startTime).count();
+}
+
+//------------------------------------------------------------------------------
+//      Method: findPath
+//
+// Description: Finds the length of a shortest path between two cells and,
+//              optionally, the path itself. The start and goal are attached to
+//              their clusters' entrances through the clusters' junction
+//              graphs; A* (with a Manhattan-distance heuristic) then searches
+//              the abstract graph of entrances only, so the cost of a query
+//              depends on the number of clusters along the way rather than on
+//              the number of cells. If both cells share a cluster, a path that
+//              stays inside it is considered too.
+//
+//      Inputs: fromX, fromY - Coordinates of the start cell.
+//              toX, toY     - Coordinates of the goal cell.
+//              path         - If not NULL, receives the indices of the cells
+//                             along the path, from start to goal inclusive.
+//
+//     Outputs: The number of steps along a shortest path, or -1 if the goal
+//              cannot be reached (or a cell is out of bounds).
+//------------------------------------------------------------------------------
+int Pathfinder::findPath(int fromX, int fromY, int toX, int toY,
+                         vector<int> *path) {
+  int from = quest_->getCellIndex(fromX, fromY),
+      to = quest_->getCellIndex(toX, toY);
+  if (path) {
+    path->clear();
+  }
+  if (from < 0 || to < 0) {
+    return -1;
+  }
+
+  int fromCluster = getClusterIndex(from),
+      toCluster = getClusterIndex(to),
+      best = -1,
+      bestNode = -1;
+  if (fromCluster == toCluster) {
+    best = searchLocally(from, to, fromCluster, path);
+    if (clusters_[fromCluster].nodes.empty()) {
+      return best;  // there is no way out of the cluster anyway
+    }
+  }
+
+  // distances from the start to its cluster's entrances, and from the goal's
+  // cluster's entrances to the goal
+  vector<PathEdge> seeds;
+  vector<int> fromDistances,
+              toDistances;
+  attach(from, fromCluster, seeds);
+  searchCluster(fromCluster, seeds, fromDistances);
+  attach(to, toCluster, seeds);
+  searchCluster(toCluster, seeds, toDistances);
+  if (++searchNo_ == 0) {
+    stamps_.assign(stamps_.size(), 0);
+    goalStamps_.assign(goalStamps_.size(), 0);
+    searchNo_ = 1;
+  }
+  const vector<int> &goalNodes = clusters_[toCluster].nodes;
+  for (int i = 0; i < goalNodes.size(); ++i) {
+    int distance = toDistances[nodes_[goalNodes[i]].junction];
+    if (distance >= 0) {
+      goalStamps_[goalNodes[i]] = searchNo_;
+      goalCosts_[goalNodes[i]] = distance;
+    }
+  }
+
+  // A* over the abstract graph
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > open;
+  int width = quest_->getWidth();
+  const vector<int> &startNodes = clusters_[fromCluster].nodes;
+  for (int i = 0; i < startNodes.size(); ++i) {
+    int node = startNodes[i],
+        cost = fromDistances[nodes_[node].junction],
+        cellIndex = nodes_[node].cellIndex;
+    if (cost >= 0) {
+      stamps_[node] = searchNo_;
+      costs_[node] = cost;
+      parents_[node] = -1;
+      open.push(make_pair(cost + abs(cellIndex % width - toX) +
+                          abs(cellIndex / width - toY), node));
+    }
+  }
+  while (!open.empty()) {
+    int estimate = open.top().first,
+        node = open.top().second;
+    open.pop();
+    if (best >= 0 && estimate >= best) {
+      break;
+    }
+    int cellIndex = nodes_[node].cellIndex,
+        cost = costs_[node];
+    if (estimate > cost + abs(cellIndex % width - toX) +
+                   abs(cellIndex / width - toY)) {
+      continue;  // superseded by a cheaper entry
+    }
+    if (goalStamps_[node] == searchNo_ &&
+        (best < 0 || cost + goalCosts_[node] < best)) {
+      best = cost + goalCosts_[node];
+      bestNode = node;
+    }
+
+    // edges within the cluster, then those crossing into neighboring ones
+    const vector<PathEdge> &edges = nodes_[node].edges;
+    PathEdge crossings[4];
+    int nCrossings = 0;
+    for (int side = NORTH; side <= WEST; ++side) {
+      int neighbor = getOpenNeighbor(cellIndex, side);
+      if (neighbor >= 0 && getClusterIndex(neighbor) != nodes_[node].cluster) {
+        crossings[nCrossings].to = nodeOfCell_[neighbor];
+        crossings[nCrossings++].length = 1;
+      }
+    }
+    for (int i = 0; i < edges.size() + nCrossings; ++i) {
+      const PathEdge &edge = i < edges.size() ? edges[i] :
+                                                crossings[i - edges.size()];
+      int newCost = cost + edge.length;
+      if (stamps_[edge.to] != searchNo_ || newCost < costs_[edge.to]) {
+        int next = nodes_[edge.to].cellIndex;
+        stamps_[edge.to] = searchNo_;
+        costs_[edge.to] = newCost;
+        parents_[edge.to] = node;
+        open.push(make_pair(newCost + abs(next % width - toX) +
+                            abs(next / width - toY), edge.to));
+      }
+    }
+  }
+
+  // refine the abstract path into cells, one cluster at a time, in place of
+  // any path found within a shared cluster (which is kept if none is shorter)
+  if (path && bestNode >= 0) {
+    vector<int> chain,
+                segment;
+    for (int node = bestNode; node >= 0; node = parents_[node]) {
+      chain.push_back(node);
+    }
+    int cellIndex = from,
+        cluster = fromCluster;
+    path->clear();
+    path->push_back(from);
+    for (int i = chain.size() - 1; i >= -1; --i) {
+      int next = (i >= 0) ? nodes_[chain[i]].cellIndex : to,
+          nextCluster = getClusterIndex(next);
+      if (nextCluster == cluster) {
+        searchLocally(cellIndex, next, cluster, &segment);
+        path->insert(path->end(), segment.begin() + 1, segment.end());
+      } else {
+        path->push_back(next);
+      }
+      cellIndex = next;
+      cluster = nextCluster;
+    }
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+//      Method: update
+//
+// Description: Brings the hierarchy up to date after the walls of a given cell
+//              have changed, by rebuilding only the cluster containing that
+//              cell and any neighboring clusters sharing one of its walls.
+//
+//      Inputs: x, y - Coordinates of the cell whose walls have changed.
+//
+//     Outputs: The number of clusters rebuilt, or -1 if the cell is out of
+//              bounds.
+//------------------------------------------------------------------------------
+int Pathfinder::update(int x, int y) {
+  int cellIndex = quest_->getCellIndex(x, y);
+  if (cellIndex < 0) {
+    return -1;
+  }
+
+  int cluster = getClusterIndex(cellIndex),
+      nRebuilt = 1;
+  buildCluster(cluster);
+  for (int side = NORTH; side <= WEST; ++side) {
+    int neighbor = quest_->getNeighborIndex(cellIndex, side);
+    if (neighbor >= 0 && getClusterIndex(neighbor) != cluster) {
+      buildCluster(getClusterIndex(neighbor));
+      ++nRebuilt;
+    }
+  }
+
+  return nRebuilt;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumClusters
+//
+// Description: Returns the number of clusters.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of clusters.
+//------------------------------------------------------------------------------
+int Pathfinder::getNumClusters() const {
+  return clusters_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumJunctions
+//
+// Description: Returns the total number of junction-graph nodes (dead ends,
+//              junctions, and entrances) across all clusters.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of junction-graph nodes.
+//------------------------------------------------------------------------------
+int Pathfinder::getNumJunctions() const {
+  int nJunctions = 0;
+
+  for (int c = 0; c < clusters_.size(); ++c) {
+    nJunctions += clusters_[c].junctions.size();
+  }
+
+  return nJunctions;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumNodes
+//
+// Description: Returns the number of abstract-graph nodes (entrances).
+//
+//      Inputs: None.
+//
+//     Outputs: The number of abstract-graph nodes.
+//------------------------------------------------------------------------------
+int Pathfinder::getNumNodes() const {
+  return nNodes_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getBuildTime
+//
+// Description: Returns how long the initial preprocessing took.
+//
+//      Inputs: None.
+//
+//     Outputs: The preprocessing time, in seconds.
+//------------------------------------------------------------------------------
+double Pathfinder::getBuildTime() const {
+  return buildTime_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: buildCluster
+//
+// Description: A private method that (re)builds a cluster's junction graph and
+//              abstract nodes. Cells that are dead ends, junctions, or
+//              entrances (i.e., open onto a neighboring cluster) become
+//              junction-graph nodes, and each run of corridor cells between
+//              two of them becomes a single weighted edge. Each entrance then
+//              gets an abstract edge to every other entrance it can reach
+//              without leaving the cluster.
+//
+//      Inputs: c - Index of the cluster.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Pathfinder::buildCluster(int c) {
+  Cluster &cluster = clusters_[c];
+
+  // release the cluster's previous nodes
+  for (int i = 0; i < cluster.nodes.size(); ++i) {
+    PathNode &node = nodes_[cluster.nodes[i]];
+    nodeOfCell_[node.cellIndex] = -1;
+    node.edges.clear();
+    freeNodes_.push_back(cluster.nodes[i]);
+    --nNodes_;
+  }
+  for (int i = 0; i < cluster.junctions.size(); ++i) {
+    junctionOfCell_[cluster.junctions[i]] = -1;
+  }
+  cluster.junctions.clear();
+  cluster.edgeOffsets.clear();
+  cluster.edges.clear();
+  cluster.nodes.clear();
+
+  // find junction-graph nodes
+  vector<int> entrances;
+  for (int y = cluster.minY; y < cluster.maxY; ++y) {
+    for (int x = cluster.minX; x < cluster.maxX; ++x) {
+      int cellIndex = quest_->getCellIndex(x, y),
+          nOpenings = 0;
+      bool isEntrance = false;
+      for (int side = NORTH; side <= WEST; ++side) {
+        int neighbor = getOpenNeighbor(cellIndex, side);
+        if (neighbor >= 0 && getClusterIndex(neighbor) == c) {
+          ++nOpenings;
+        } else if (neighbor >= 0) {
+          isEntrance = true;
+        }
+      }
+      if (isEntrance || nOpenings != 2) {
+        if (isEntrance) {
+          entrances.push_back(cluster.junctions.size());
+        }
+        junctionOfCell_[cellIndex] = cluster.junctions.size();
+        cluster.junctions.push_back(cellIndex);
+      }
+    }
+  }
+
+  // follow each corridor leaving each node to the node at its other end
+  for (int j = 0; j < cluster.junctions.size(); ++j) {
+    cluster.edgeOffsets.push_back(cluster.edges.size());
+    attach(cluster.junctions[j], -1 - c, cluster.edges);
+  }
+  cluster.edgeOffsets.push_back(cluster.edges.size());
+
+  // create abstract nodes for the entrances and connect them
+  for (int i = 0; i < entrances.size(); ++i) {
+    int id;
+    if (freeNodes_.empty()) {
+      id = nodes_.size();
+      nodes_.push_back(PathNode());
+    } else {
+      id = freeNodes_.back();
+      freeNodes_.pop_back();
+    }
+    nodes_[id].cellIndex = cluster.junctions[entrances[i]];
+    nodes_[id].cluster = c;
+    nodes_[id].junction = entrances[i];
+    nodeOfCell_[nodes_[id].cellIndex] = id;
+    cluster.nodes.push_back(id);
+    ++nNodes_;
+  }
+  if (costs_.size() < nodes_.size()) {
+    costs_.resize(nodes_.size());
+    goalCosts_.resize(nodes_.size());
+    parents_.resize(nodes_.size());
+    stamps_.resize(nodes_.size(), 0);
+    goalStamps_.resize(nodes_.size(), 0);
+  }
+  vector<PathEdge> seeds(1);
+  vector<int> distances;
+  for (int i = 0; i < cluster.nodes.size(); ++i) {
+    seeds[0].to = entrances[i];
+    seeds[0].length = 0;
+    searchCluster(c, seeds, distances);
+    for (int k = 0; k < cluster.nodes.size(); ++k) {
+      if (k != i && distances[entrances[k]] >= 0) {
+        PathEdge edge = {cluster.nodes[k], distances[entrances[k]]};
+        nodes_[cluster.nodes[i]].edges.push_back(edge);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getClusterIndex
+//
+// Description: A private method that returns the index of the cluster
+//              containing a given cell.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//
+//     Outputs: The cluster's index.
+//------------------------------------------------------------------------------
+int Pathfinder::getClusterIndex(int cellIndex) const {
+  int width = quest_->getWidth();
+
+  return (cellIndex % width) / clusterSize_ +
+         (cellIndex / width) / clusterSize_ * clustersX_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getOpenNeighbor
+//
+// Description: A private method that returns the neighbor of a given cell
+//              along a given side, provided no wall lies between them.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              side      - Integer representing the side of interest (NORTH,
+//                          SOUTH, EAST, or WEST).
+//
+//     Outputs: The neighbor's index, or -1 if there is a wall or no neighbor.
+//------------------------------------------------------------------------------
+int Pathfinder::getOpenNeighbor(int cellIndex, int side) const {
+  if (quest_->getCell(cellIndex).hasWallAt(side)) {
+    return -1;
+  }
+
+  return quest_->getNeighborIndex(cellIndex, side);
+}
+
+//------------------------------------------------------------------------------
+//      Method: attach
+//
+// Description: A private method that finds the junction-graph nodes nearest a
+//              given cell of a cluster by following each corridor leading
+//              away from the cell until it reaches a node (corridor cells have
+//              exactly two openings, both within the cluster, so each
+//              corridor leads to exactly one node). A cell that is itself a
+//              node is its own nearest node, unless 'c' is encoded as
+//              -1 - cluster, in which case only the corridors' far ends are
+//              found (used to build the junction graph).
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              c         - Index of the cell's cluster (see above).
+//              seeds     - Receives one (node, distance) pair per corridor.
+//                          When building, pairs are appended instead.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Pathfinder::attach(int cellIndex, int c, vector<PathEdge> &seeds) const {
+  bool building = (c < 0);
+  if (building) {
+    c = -1 - c;
+  } else {
+    seeds.clear();
+    if (junctionOfCell_[cellIndex] >= 0) {
+      PathEdge seed = {junctionOfCell_[cellIndex], 0};
+      seeds.push_back(seed);
+      return;
+    }
+  }
+
+  const Cluster &cluster = clusters_[c];
+  int maxLength = (cluster.maxX - cluster.minX) *
+                  (cluster.maxY - cluster.minY);
+  for (int side = NORTH; side <= WEST; ++side) {
+    int previous = cellIndex,
+        current = getOpenNeighbor(cellIndex, side),
+        length = 1;
+    if (current < 0 || getClusterIndex(current) != c) {
+      continue;
+    }
+    while (junctionOfCell_[current] < 0 && length <= maxLength) {
+      int next = -1;
+      for (int s = NORTH; s <= WEST && next < 0; ++s) {
+        int neighbor = getOpenNeighbor(current, s);
+        if (neighbor >= 0 && neighbor != previous) {
+          next = neighbor;
+        }
+      }
+      previous = current;
+      current = next;
+      ++length;
+    }
+    if (junctionOfCell_[current] >= 0) {  // else a loop with no nodes at all
+      PathEdge seed = {junctionOfCell_[current], length};
+      seeds.push_back(seed);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: searchCluster
+//
+// Description: A private method that computes the shortest distances, within
+//              a cluster, from a set of starting junction-graph nodes to all of
+//              the cluster's nodes (Dijkstra's algorithm over the junction
+//              graph).
+//
+//      Inputs: c         - Index of the cluster.
+//              seeds     - Starting nodes and their initial distances.
+//              distances - Receives the distance to each node of the cluster
+//                          (-1 if unreachable within the cluster).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Pathfinder::searchCluster(int c, const vector<PathEdge> &seeds,
+                               vector<int> &distances) const {
+  const Cluster &cluster = clusters_[c];
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > open;
+
+  distances.assign(cluster.junctions.size(), -1);
+  for (int i = 0; i < seeds.size(); ++i) {
+    int j = seeds[i].to;
+    if (distances[j] < 0 || seeds[i].length < distances[j]) {
+      distances[j] = seeds[i].length;
+      open.push(make_pair(distances[j], j));
+    }
+  }
+  while (!open.empty()) {
+    int distance = open.top().first,
+        j = open.top().second;
+    open.pop();
+    if (distance > distances[j]) {
+      continue;
+    }
+    for (int e = cluster.edgeOffsets[j]; e < cluster.edgeOffsets[j + 1]; ++e) {
+      const PathEdge &edge = cluster.edges[e];
+      if (distances[edge.to] < 0 ||
+          distance + edge.length < distances[edge.to]) {
+        distances[edge.to] = distance + edge.length;
+        open.push(make_pair(distances[edge.to], edge.to));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: searchLocally
+//
+// Description: A private method that finds a shortest path between two cells
+//              of the same cluster that does not leave the cluster
+//              (breadth-first search over the cluster's cells).
+//
+//      Inputs: from, to - Indices of the start and goal cells.
+//              c        - Index of their cluster.
+//              path     - If not NULL, receives the indices of the cells along
+//                         the path, from start to goal inclusive.
+//
+//     Outputs: The number of steps along the path, or -1 if the goal cannot be
+//              reached without leaving the cluster.
+//------------------------------------------------------------------------------
+int Pathfinder::searchLocally(int from, int to, int c,
+                              vector<int> *path) const {
+  const Cluster &cluster = clusters_[c];
+  int width = quest_->getWidth(),
+      clusterWidth = cluster.maxX - cluster.minX,
+      nCells = clusterWidth * (cluster.maxY - cluster.minY);
+  vector<int> parents(nCells, -1),
+              queue;
+
+  // cells are indexed locally, relative to the cluster's corner
+  int start = from % width - cluster.minX +
+              (from / width - cluster.minY) * clusterWidth,
+      goal = to % width - cluster.minX +
+             (to / width - cluster.minY) * clusterWidth;
+  parents[start] = start;
+  queue.push_back(start);
+  for (int head = 0; head < queue.size() && parents[goal] < 0; ++head) {
+    int local = queue[head],
+        cellIndex = cluster.minX + local % clusterWidth +
+                    (cluster.minY + local / clusterWidth) * width;
+    for (int side = NORTH; side <= WEST; ++side) {
+      int neighbor = getOpenNeighbor(cellIndex, side);
+      if (neighbor < 0 || getClusterIndex(neighbor) != c) {
+        continue;
+      }
+      int next = neighbor % width - cluster.minX +
+                 (neighbor / width - cluster.minY) * clusterWidth;
+      if (parents[next] < 0) {
+        parents[next] = local;
+        queue.push_back(next);
+      }
+    }
+  }
+  if (parents[goal] < 0) {
+    return -1;
+  }
+
+  int nSteps = 0;
+  if (path) {
+    path->clear();
+  }
+  for (int local = goal; ; local = parents[local]) {
+    if (path) {
+      path->push_back(cluster.minX + local % clusterWidth +
+                      (cluster.minY + local / clusterWidth) * width);
+    }
+    if (local == start) {
+      break;
+    }
+    ++nSteps;
+  }
+  if (path) {
+    reverse(path->begin(), path->end());
+  }
+
+  return nSteps;
+}
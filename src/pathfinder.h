@@ -0,0 +1,96 @@
+/*******************************************************************************
+   Filename: pathfinder.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Pathfinder' class, which answers shortest-path
+             queries over a quest's maze using a two-level hierarchy (HPA*):
+             the maze is split into square clusters, each cluster's corridors
+             are collapsed into a junction graph, and the cells through which
+             paths cross cluster borders ("entrances") form an abstract graph
+             whose edges hold precomputed in-cluster distances.
+*******************************************************************************/
+
+#ifndef PATHFINDER_H_
+#define PATHFINDER_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Quest;
+
+const int DEFAULT_CLUSTER_SIZE = 32;  // cells per side
+
+// An edge of a junction graph (a corridor) or of the abstract graph. 'to' is a
+// junction's index within its cluster or an entrance's node index,
+// respectively.
+struct PathEdge {
+  int to,
+      length;  // in steps between cells
+};
+
+// A square block of cells and its junction graph: every cell that is a dead
+// end, a junction, or an entrance is a junction-graph node, and runs of
+// corridor cells between them are edges.
+struct Cluster {
+  int minX,
+      minY,
+      maxX,  // exclusive
+      maxY;  // exclusive
+  vector<int> junctions;    // cell index of each node
+  vector<int> edgeOffsets;  // edges of node j: [edgeOffsets[j], [j + 1])
+  vector<PathEdge> edges;
+  vector<int> nodes;        // abstract node of each entrance
+};
+
+// An entrance cell, i.e., a node of the abstract graph. Edges to entrances of
+// the same cluster are stored; those crossing into neighboring clusters are
+// found from the cell's walls.
+struct PathNode {
+  int cellIndex,
+      cluster,
+      junction;  // index within its cluster's junction graph
+  vector<PathEdge> edges;
+};
+
+class Pathfinder {
+ public:
+  Pathfinder(const Quest *quest, int clusterSize = DEFAULT_CLUSTER_SIZE);
+  int findPath(int fromX, int fromY, int toX, int toY,
+               vector<int> *path = NULL);
+  int update(int x, int y);
+  int getNumClusters() const;
+  int getNumJunctions() const;
+  int getNumNodes() const;
+  double getBuildTime() const;
+ private:
+  const Quest *quest_;
+  int clusterSize_,
+      clustersX_,
+      clustersY_,
+      nNodes_;
+  double buildTime_;
+  vector<Cluster> clusters_;
+  vector<PathNode> nodes_;
+  vector<int> freeNodes_,
+              junctionOfCell_,  // index within its cluster, or -1
+              nodeOfCell_,      // abstract node, or -1
+              costs_,           // per node, valid when stamps_ matches
+              goalCosts_,
+              parents_;
+  vector<unsigned> stamps_,
+                   goalStamps_;
+  unsigned searchNo_;
+
+  void buildCluster(int c);
+  int getClusterIndex(int cellIndex) const;
+  int getOpenNeighbor(int cellIndex, int side) const;
+  void attach(int cellIndex, int c, vector<PathEdge> &seeds) const;
+  void searchCluster(int c, const vector<PathEdge> &seeds,
+                     vector<int> &distances) const;
+  int searchLocally(int from, int to, int c, vector<int> *path) const;
+};
+
+#endif  // PATHFINDER_H_
@@ -9,23 +9,46 @@ Description: Definition of a 'Quest' class responsible for managing all aspects
 *******************************************************************************/
 
 #include "quest.h"
+#include "simulation.h"
 
 //------------------------------------------------------------------------------
 //      Method: Quest
 //
 // Description: Constructs a Quest object (via the 'initialize' method)
-//              according to a given quest number, width, height, and
-//              perspective.
+//              according to a given quest number, width, height, perspective,
+//              random seed, number of maze generation threads, and maze
+//              algorithm.
 //
 //      Inputs: questNo     - Integer representing a specific quest.
 //              width       - Number of cell columns.
 //              height      - Number of cell rows.
 //              perspective - Integer representing the desired perspective.
+//              seed        - Seed for all of the quest's random choices.
+//              nThreads    - Number of maze generation threads (0 to decide
+//                            automatically).
+//              algorithm   - Integer representing the maze algorithm
+//                            (DEPTH_FIRST or ROW_BY_ROW).
 //
 //     Outputs: None.
 //------------------------------------------------------------------------------
-Quest::Quest(int questNo, int width, int height, int perspective) {
-  initialize(questNo, width, height, perspective);
+Quest::Quest(int questNo, int width, int height, int perspective,
+             uint64_t seed, int nThreads, int algorithm) {
+  initialize(questNo, width, height, perspective, seed, nThreads, algorithm);
+}
+
+//------------------------------------------------------------------------------
+//      Method: Quest
+//
+// Description: Constructs a Quest object (via the 'initialize' method) from a
+//              previously saved quest file.
+//
+//      Inputs: file        - An open quest file (see 'QuestFile::open').
+//              perspective - Integer representing the desired perspective.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Quest::Quest(const QuestFile &file, int perspective) {
+  initialize(file, perspective);
 }
 
 //------------------------------------------------------------------------------
@@ -39,7 +62,40 @@ Quest::Quest(int questNo, int width, int height, int perspective) {
 //------------------------------------------------------------------------------
 Quest::~Quest() {
   cells_.clear();
+  for (int i = 0; i < characters_.size(); ++i) {
+    delete characters_[i];
+  }
   characters_.clear();
+  if (world_) {
+    delete world_;
+  }
+  if (pathfinder_) {
+    delete pathfinder_;
+  }
+  if (lighting_) {
+    delete lighting_;
+  }
+  if (renderQueue_) {
+    delete renderQueue_;
+  }
+  if (visibility_) {
+    delete visibility_;
+  }
+  for (int i = 0; i < visibleMeshes_.size(); ++i) {
+    delete visibleMeshes_[i];
+  }
+  if (frustum_) {
+    delete frustum_;
+  }
+  if (crowd_) {
+    delete crowd_;
+  }
+  if (overview_) {
+    delete overview_;
+  }
+  for (int i = 0; i < meshes_.size(); ++i) {
+    delete meshes_[i];
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -47,92 +103,219 @@ Quest::~Quest() {
 //
 // Description: Initializes the Quest object -- including all associated cells,
 //              NPCs, and items -- according to a given quest number, width,
-//              height, and perspective.
+//              height, perspective, and seed. Identical arguments always yield
+//              an identical quest. Depth-first mazes of at least
+//              PARALLEL_GENERATION_MIN_CELLS cells are carved in tiles, which
+//              are spread across threads; the tile layout never depends on the
+//              thread count, so neither does the resulting maze.
 //
 //      Inputs: questNo     - Integer representing a specific quest.
 //              width       - Number of cell columns.
 //              height      - Number of cell rows.
 //              perspective - Integer representing the desired perspective.
+//              seed        - Seed for all of the quest's random choices.
+//              nThreads    - Number of threads used to carve tiles (0 to use
+//                            all cores). Ignored for smaller mazes and by
+//                            ROW_BY_ROW.
+//              algorithm   - Integer representing the maze algorithm
+//                            (DEPTH_FIRST or ROW_BY_ROW).
 //
 //     Outputs: None.
 //------------------------------------------------------------------------------
-void Quest::initialize(int questNo, int width, int height, int perspective) {
+void Quest::initialize(int questNo, int width, int height, int perspective,
+                       uint64_t seed, int nThreads, int algorithm) {
   questNo_ = questNo;
   width_ = width;
   height_ = height;
   perspective_ = perspective;
+  seed_ = seed;
+  random_.seed(seed);
+  generationTime_ = 0.0;
+  player_ = NULL;
+  world_ = NULL;
+  pathfinder_ = NULL;
+  lighting_ = NULL;
+  meshes_.clear();
+  renderQueue_ = NULL;
+  visibility_ = NULL;
+  visibleMeshes_.clear();
+  frustum_ = NULL;
+  crowd_ = NULL;
+  overview_ = NULL;
+  explored_.clear();
+  nVisibleChunks_ = 0;
+  nCulledChunks_ = 0;
   initializeCells();
-  removeWalls(0, 0);
+  if (nThreads <= 0) {
+    nThreads = max(1, (int) thread::hardware_concurrency());
+  }
+  if (algorithm == ROW_BY_ROW) {
+    removeWallsByRows();
+  } else if (width_ * (double) height_ >= PARALLEL_GENERATION_MIN_CELLS) {
+    removeWallsInParallel(nThreads);
+  } else {
+    removeWalls(0, 0);
+  }
   setStartAndFinish();
 
   // remove ceiling tiles (if desired)
   if (false) {
-    for (int i = 0; i < DEFAULT_MAZE_WIDTH; ++i) {
-      for (int j = 0; j < DEFAULT_MAZE_HEIGHT; ++j) {
+    for (int i = 0; i < width_; ++i) {
+      for (int j = 0; j < height_; ++j) {
         int cellIndex = i + j * width_;
         if (cellIndex < 0 || cellIndex > cells_.size()) {
           continue;
         }
-        cells_[cellIndex]->removeWall(TOP);
+        cells_[cellIndex].removeWall(TOP);
       }
     }
   }
 
-  // set default textures
+  // set default textures (the start and finish doors use DOOR_MATERIAL)
   int t = 0 + TEXTURE_OFFSET_PER_QUEST * (questNo - 1);
-  for (int i = 0; i < DEFAULT_MAZE_WIDTH; ++i) {
-    for (int j = 0; j < DEFAULT_MAZE_HEIGHT; ++j) {
-      // Set north, south, east, and west wall textures:
-      for (int side = 0; side < 4; ++side) {
-        cells_[i + j * width_]->setTexture(side, getTextureNo(t));
-      }
+  materials_[WALL_MATERIAL] = t;
+  materials_[FLOOR_MATERIAL] = t + 1;
+  materials_[CEILING_MATERIAL] = t + 2;
+  materials_[DOOR_MATERIAL] = t + 3;
 
-      // set floor texture
-      cells_[i + j * width_]->setTexture(BOTTOM, getTextureNo(t + 1));
+  // initialize NPCs
+  initializeCharacters();
+}
 
-      // set ceiling texture
-      cells_[i + j * width_]->setTexture(TOP, getTextureNo(t + 2));
-    }
+//------------------------------------------------------------------------------
+//      Method: initialize
+//
+// Description: Initializes the Quest object from a quest file instead of
+//              generating it: the file's packed wall bits are decoded into the
+//              cell grid in a single linear pass (no parsing), so the file
+//              need not stay open afterward, and one NPC is created at each
+//              saved spawn point. The random stream is re-seeded from the
+//              saved seed, so the NPCs' later choices match those of the quest
+//              that was saved.
+//
+//      Inputs: file        - An open quest file (see 'QuestFile::open').
+//              perspective - Integer representing the desired perspective.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::initialize(const QuestFile &file, int perspective) {
+  const QuestFileHeader *header = file.getHeader();
+
+  questNo_ = header->questNo;
+  width_ = header->width;
+  height_ = header->height;
+  startX_ = header->startX;
+  finishX_ = header->finishX;
+  perspective_ = perspective;
+  seed_ = header->seed;
+  random_.seed(seed_);
+  generationTime_ = 0.0;
+  player_ = NULL;
+  world_ = NULL;
+  pathfinder_ = NULL;
+  lighting_ = NULL;
+  meshes_.clear();
+  renderQueue_ = NULL;
+  visibility_ = NULL;
+  visibleMeshes_.clear();
+  frustum_ = NULL;
+  crowd_ = NULL;
+  overview_ = NULL;
+  explored_.clear();
+  nVisibleChunks_ = 0;
+  nCulledChunks_ = 0;
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    materials_[m] = header->textures[m];
   }
 
-  // set start and finish door textures
-  cells_[startX_]->setTexture(SOUTH, getTextureNo(t + 3));
-  cells_[finishX_ + (height_ - 1) * width_]->setTexture(NORTH,
-                                                        getTextureNo(t + 3));
+  // decode walls (each removal also clears the neighbor's matching wall)
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  const unsigned char *walls = file.getWalls();
+  initializeCells();
+  for (int cellIndex = 0; cellIndex < cells_.size(); ++cellIndex) {
+    int bits = walls[cellIndex / QUEST_FILE_CELLS_PER_BYTE] >>
+               (cellIndex % QUEST_FILE_CELLS_PER_BYTE * 2);
+    if (!(bits & 1) && cellIndex + width_ < cells_.size()) {
+      removeWall(cellIndex, NORTH);
+    }
+    if (!(bits & 2) && (cellIndex + 1) % width_ != 0) {
+      removeWall(cellIndex, EAST);
+    }
+  }
+  generationTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                             startTime).count();
 
-  // initialize NPCs
-  initializeCharacters();
+  // create NPCs at their saved positions
+  const QuestFileSpawn *spawns = file.getSpawns();
+  characters_.clear();
+  for (int i = 0; i < header->numSpawns; ++i) {
+    Character *character = new Character(spawns[i].type, this);
+    character->setPosition(spawns[i].x, spawns[i].y, spawns[i].rotation);
+    characters_.push_back(character);
+  }
 }
 
 //------------------------------------------------------------------------------
-//      Method: initializeCells
+//      Method: save
 //
-// Description: Creates and initializes all Cell objects associated with the
-//              current quest and adds them to the 'cells_' vector.
+// Description: Writes the quest -- its maze, start and finish, materials, seed,
+//              and the current positions of its NPCs -- to a quest file (see
+//              questfile.h), from which it can later be reloaded without being
+//              regenerated.
 //
-//      Inputs: None.
+//      Inputs: filename - Path of the file to be created.
 //
-//     Outputs: The number of cells created.
+//     Outputs: 0 if successful, -1 otherwise.
 //------------------------------------------------------------------------------
-int Quest::initializeCells() {
-  int nCells = 0;
+int Quest::save(const char *filename) const {
+  QuestFileHeader header;
+  QuestFileWriter writer;
+  vector<QuestFileSpawn> spawns;
 
-  cells_.clear();
-  for (int i = 0; i < width_; ++i) {
-    for (int j = 0; j < height_; ++j) {
-      cells_.push_back(new Cell());
-      ++nCells;
-    }
+  initializeQuestFileHeader(header, width_, height_, characters_.size());
+  header.questNo = questNo_;
+  header.startX = startX_;
+  header.finishX = finishX_;
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    header.textures[m] = materials_[m];
+  }
+  header.seed = seed_;
+  for (int i = 0; i < characters_.size(); ++i) {
+    QuestFileSpawn spawn = {characters_[i]->getType(),
+                            (float) characters_[i]->getX(),
+                            (float) characters_[i]->getY(),
+                            (float) characters_[i]->getRotation()};
+    spawns.push_back(spawn);
   }
 
-  // assign each cell a pointer to each of its neighbors
-  for (int i = 0; i < DEFAULT_MAZE_WIDTH; ++i) {
-    for (int j = 0; j < DEFAULT_MAZE_HEIGHT; ++j) {
-      assignNeighbors(i, j);
+  if (!writer.open(filename, header)) {
+    return -1;
+  }
+  for (int y = 0; y < height_; ++y) {
+    if (!writer.writeRow(&cells_[getCellIndex(0, y)])) {
+      return -1;
     }
   }
 
-  return nCells;
+  return writer.finish(spawns.empty() ? NULL : &spawns[0]) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: initializeCells
+//
+// Description: Resets the 'cells_' grid to width_ x height_ cells, each with
+//              walls on all sides. Cells are stored contiguously in row-major
+//              order (see 'getCellIndex'), so neighbors are found by index
+//              rather than by pointer.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of cells created.
+//------------------------------------------------------------------------------
+int Quest::initializeCells() {
+  cells_.assign(width_ * height_, Cell());
+
+  return cells_.size();
 }
 
 //------------------------------------------------------------------------------
@@ -159,83 +342,383 @@ int Quest::initializeCharacters() {
 }
 
 //------------------------------------------------------------------------------
-//      Method: assignNeighbors
+//      Method: addCharacters
 //
-// Description: Assigns neighbor pointers to the cell located at a given set of
-//              coordinates.
+// Description: Adds a given number of NPCs (goblins and orcs, alternately) at
+//              random locations, e.g., to populate a quest with a large crowd.
 //
-//      Inputs: x, y - Coordinates of the cell to be assigned neighbors.
+//      Inputs: nCharacters - Number of NPCs to add.
 //
-//     Outputs: The number of neighbors assigned, or -1 if the arguments are
-//              invalid.
+//     Outputs: The total number of NPCs in the quest.
 //------------------------------------------------------------------------------
-int Quest::assignNeighbors(int x, int y) {
-  int nNeighbors = 0;
+int Quest::addCharacters(int nCharacters) {
+  for (int i = 0; i < nCharacters; ++i) {
+    characters_.push_back(new Character(i % 2 == 0 ? GOBLIN : ORC, this));
+  }
 
-  if (x < 0 || y < 0 || x >= DEFAULT_MAZE_WIDTH || y >= DEFAULT_MAZE_HEIGHT) {
+  return characters_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: removeWalls
+//
+// Description: Removes cell walls so as to create a maze, starting from a given
+//              cell, on the calling thread. Also records how long generation
+//              took (see 'getGenerationRate').
+//
+//      Inputs: i, j - Coordinates of the cell from which carving begins.
+//
+//     Outputs: 0 if successful, -1 if the arguments are invalid.
+//------------------------------------------------------------------------------
+int Quest::removeWalls(int i, int j) {
+  if (i < 0 || j < 0 || i >= width_ || j >= height_) {
+    return -1;
+  }
+
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  Tile maze = {0, 0, width_, height_, random_.split()};
+  vector<int> stack;
+  carveTile(maze, getCellIndex(i, j), stack);
+  generationTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                             startTime).count();
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: removeWallsInParallel
+//
+// Description: Removes cell walls so as to create a maze using several worker
+//              threads. The grid is split into PARALLEL_TILE_SIZE tiles (many
+//              per thread, for load balancing), each tile is carved into a
+//              perfect maze of its own, and a final pass joins the tiles along
+//              a random spanning tree with exactly one opening per joined
+//              border, so the result is still a perfect maze. Also records how
+//              long generation took (see 'getGenerationRate').
+//
+//      Inputs: nThreads - Number of worker threads.
+//
+//     Outputs: The number of tiles carved, or -1 if the argument is invalid.
+//------------------------------------------------------------------------------
+int Quest::removeWallsInParallel(int nThreads) {
+  if (nThreads < 1) {
     return -1;
   }
 
-  for (int i = 0; i < 4; ++i) {
-    if (x - 1 >= 0) {
-      cells_[x + y * width_]->setNeighbor(WEST, cells_[x - 1 + y * width_]);
-      ++nNeighbors;
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  int tileSize = PARALLEL_TILE_SIZE;
+  int tilesX = (width_ + tileSize - 1) / tileSize;
+  int tilesY = (height_ + tileSize - 1) / tileSize;
+  vector<Tile> tiles;
+
+  // each tile gets its own stream, split off in tile order so the maze does
+  // not depend on which worker carves which tile
+  for (int ty = 0; ty < tilesY; ++ty) {
+    for (int tx = 0; tx < tilesX; ++tx) {
+      Tile tile = {tx * tileSize,
+                   ty * tileSize,
+                   min(width_, (tx + 1) * tileSize),
+                   min(height_, (ty + 1) * tileSize),
+                   random_.split()};
+      tiles.push_back(tile);
     }
-    if (x + 1 < DEFAULT_MAZE_WIDTH) {
-      cells_[x + y * width_]->setNeighbor(EAST, cells_[x + 1 + y * width_]);
-      ++nNeighbors;
+  }
+
+  atomic<int> nextTile(0);
+  vector<thread> workers;
+  for (int i = 0; i < min(nThreads, (int) tiles.size()); ++i) {
+    workers.push_back(thread(&Quest::carveTiles, this, &tiles, &nextTile));
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+  stitchTiles(tiles, tilesX, tilesY);
+  generationTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                             startTime).count();
+
+  return tiles.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: removeWallsByRows
+//
+// Description: Creates a maze with Eller's algorithm, writing each generated
+//              row straight into the cell grid. Unlike 'removeWalls', no
+//              visited state or backtracking stack is needed, so the only
+//              working memory is proportional to the maze's width. Also records
+//              how long generation took (see 'getGenerationRate').
+//
+//      Inputs: None.
+//
+//     Outputs: The number of rows generated.
+//------------------------------------------------------------------------------
+int Quest::removeWallsByRows() {
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  EllerGenerator rows(width_, height_, random_.split());
+  int nRows;
+
+  for (nRows = 0; nRows < height_; ++nRows) {
+    rows.nextRow(&cells_[nRows * width_]);
+  }
+  generationTime_ = chrono::duration<double>(chrono::steady_clock::now() -
+                                             startTime).count();
+
+  return nRows;
+}
+
+//------------------------------------------------------------------------------
+//      Method: removeWall
+//
+// Description: Removes a wall along a given side of a given cell, along with
+//              the corresponding wall of that cell's neighbor (i.e., "the other
+//              side of the wall") if a neighbor exists there.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              side      - Integer representing the side of interest (NORTH,
+//                          SOUTH, EAST, WEST, TOP, or BOTTOM).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::removeWall(int cellIndex, int side) {
+  int neighbor = getNeighborIndex(cellIndex, side);
+
+  cells_[cellIndex].removeWall(side);
+  if (neighbor >= 0) {
+    cells_[neighbor].removeWall(oppositeSide(side));
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: setWall
+//
+// Description: Adds or removes a wall along a given side of a given cell
+//              after the maze has been generated (e.g., a door being opened or
+//              a passage collapsing), keeping the neighboring cell, the
+//              pathfinder (if built), and the baked lighting (if any)
+//              consistent with it. Outer walls cannot be removed.
+//
+//      Inputs: x, y    - Coordinates of the cell of interest.
+//              side    - Integer representing the side of interest (NORTH,
+//                        SOUTH, EAST, WEST, TOP, or BOTTOM).
+//              present - 'true' if a wall should exist along the given side.
+//
+//     Outputs: 0 if successful, -1 if the arguments are invalid.
+//------------------------------------------------------------------------------
+int Quest::setWall(int x, int y, int side, bool present) {
+  int cellIndex = getCellIndex(x, y);
+  if (cellIndex < 0 || side < 0 || side >= NUM_SIDES) {
+    return -1;
+  }
+  int neighbor = getNeighborIndex(cellIndex, side);
+  if (neighbor < 0 && side < TOP && !present) {
+    return -1;
+  }
+
+  cells_[cellIndex].setWall(side, present);
+  if (neighbor >= 0) {
+    cells_[neighbor].setWall(oppositeSide(side), present);
+  }
+  if (pathfinder_) {
+    pathfinder_->update(x, y);
+  }
+
+  // cells this near may see the wall (or a torch past it) differently now
+  int r = 1;
+  if (lighting_) {
+    r += (int) ceil(TORCH_RADIUS);
+    lighting_->bakeRegion(x - r, y - r, x + r + 1, y + r + 1);
+  }
+  if (!meshes_.empty()) {
+    int minX = max(0, x - r) / MESH_BLOCK_SIZE * MESH_BLOCK_SIZE,
+        minY = max(0, y - r) / MESH_BLOCK_SIZE * MESH_BLOCK_SIZE;
+    for (int j = minY; j <= min(height_ - 1, y + r); j += MESH_BLOCK_SIZE) {
+      for (int i = minX; i <= min(width_ - 1, x + r); i += MESH_BLOCK_SIZE) {
+        buildMesh(i, j);
+      }
     }
-    if (y - 1 >= 0) {
-      cells_[x + y * width_]->setNeighbor(SOUTH, cells_[x + (y - 1) * width_]);
-      ++nNeighbors;
+  }
+  if (visibility_) {
+    visibility_->invalidate();
+  }
+  if (overview_) {
+    overview_->invalidate();
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: removeRandomWall
+//
+// Description: Removes a wall of a given cell along one of the four cardinal
+//              directions, randomly selected, unless no valid removal can
+//              occur in any of those directions (the cell must have both a
+//              wall and an unvisited neighbor within the same tile in a given
+//              direction for it to be valid).
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              tile      - The tile being carved (its stream is advanced).
+//
+//     Outputs: An integer representing the side where a wall was removed
+//              (NORTH, SOUTH, EAST, or WEST), or -1 if no wall was removed.
+//------------------------------------------------------------------------------
+int Quest::removeRandomWall(int cellIndex, Tile &tile) {
+  int x = cellIndex % width_;
+  int y = cellIndex / width_;
+  int availablePaths = 0, sides[4], neighbors[4];
+
+  for (int side = 0; side < 4; ++side) {
+    int neighbor = -1;
+    if (side == NORTH && y + 1 < tile.maxY) {
+      neighbor = cellIndex + width_;
+    } else if (side == SOUTH && y > tile.minY) {
+      neighbor = cellIndex - width_;
+    } else if (side == EAST && x + 1 < tile.maxX) {
+      neighbor = cellIndex + 1;
+    } else if (side == WEST && x > tile.minX) {
+      neighbor = cellIndex - 1;
     }
-    if (y + 1 < DEFAULT_MAZE_HEIGHT) {
-      cells_[x + y * width_]->setNeighbor(NORTH, cells_[x + (y + 1) * width_]);
-      ++nNeighbors;
+    if (neighbor >= 0 && cells_[cellIndex].hasWallAt(side) &&
+        !cells_[neighbor].hasBeenVisited()) {
+      sides[availablePaths] = side;
+      neighbors[availablePaths++] = neighbor;
     }
   }
+  if (availablePaths == 0) {
+    return -1;
+  }
+
+  int choice = tile.random.nextInt(availablePaths);
+  cells_[cellIndex].removeWall(sides[choice]);
+  cells_[neighbors[choice]].removeWall(oppositeSide(sides[choice]));
 
-  return nNeighbors;
+  return sides[choice];
 }
 
 //------------------------------------------------------------------------------
-//      Method: removeWalls
+//      Method: carveTile
 //
-// Description: Recursively removes cell walls so as to create a maze.
+// Description: A private method that carves a perfect maze within a single
+//              tile, starting from a given cell. Uses an explicit stack of
+//              cell indices (preallocated to the tile's area) rather than
+//              recursion, so stack depth never grows with maze area. Only
+//              cells inside the tile are read or written, which allows
+//              disjoint tiles to be carved concurrently.
 //
-//      Inputs: i, j - Coordinates of the cell to be checked for a suitable
-//                     wall to remove.
+//      Inputs: tile      - The tile to be carved.
+//              cellIndex - Index of the cell (within the tile) to start from.
+//              stack     - Scratch storage, reused between calls.
 //
-//     Outputs: 0 if successful, -1 if the arguments are invalid.
+//     Outputs: None.
 //------------------------------------------------------------------------------
-int Quest::removeWalls(int i, int j) {
-  int wall, cellIndex = i + j * width_;
+void Quest::carveTile(Tile &tile, int cellIndex, vector<int> &stack) {
+  stack.clear();
+  stack.reserve((tile.maxX - tile.minX) * (tile.maxY - tile.minY));
+  stack.push_back(cellIndex);
+  cells_[cellIndex].setVisited(true);
+  while (!stack.empty()) {
+    int wall = removeRandomWall(stack.back(), tile);
 
-  if (i < 0 || j < 0 || i >= DEFAULT_MAZE_WIDTH || j >= DEFAULT_MAZE_HEIGHT) {
-    return -1;
+    if (wall < 0) {  // dead end: backtrack
+      stack.pop_back();
+      continue;
+    }
+    int next = getNeighborIndex(stack.back(), wall);
+    cells_[next].setVisited(true);
+    stack.push_back(next);
   }
+}
 
-  cells_[cellIndex]->setVisited(true);
-  while ((wall = cells_[cellIndex]->removeRandomWall()) >= 0) {
-    switch (wall) {
+//------------------------------------------------------------------------------
+//      Method: carveTiles
+//
+// Description: A private method run by each maze generation worker thread.
+//              Repeatedly claims the next uncarved tile and carves it until no
+//              tiles remain.
+//
+//      Inputs: tiles    - All tiles of the maze.
+//              nextTile - Shared index of the next tile to be claimed.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::carveTiles(vector<Tile> *tiles, atomic<int> *nextTile) {
+  vector<int> stack;
+  int t;
+
+  while ((t = (*nextTile)++) < (int) tiles->size()) {
+    Tile &tile = (*tiles)[t];
+    carveTile(tile, getCellIndex(tile.minX, tile.minY), stack);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: stitchTiles
+//
+// Description: A private method that joins independently carved tiles into a
+//              single perfect maze. Walks the tile grid depth-first in random
+//              order, opening one randomly placed wall along the border of
+//              each tile and the tile it was first reached from.
+//
+//      Inputs: tiles          - All tiles of the maze (row-major).
+//              tilesX, tilesY - Number of tile columns and rows.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::stitchTiles(vector<Tile> &tiles, int tilesX, int tilesY) {
+  vector<bool> joined(tiles.size(), false);
+  vector<int> stack;
+
+  stack.push_back(0);
+  joined[0] = true;
+  while (!stack.empty()) {
+    int t = stack.back();
+    int tx = t % tilesX, ty = t / tilesX;
+    int availableSides = 0, sides[4];
+
+    if (ty + 1 < tilesY && !joined[t + tilesX]) {
+      sides[availableSides++] = NORTH;
+    }
+    if (ty > 0 && !joined[t - tilesX]) {
+      sides[availableSides++] = SOUTH;
+    }
+    if (tx + 1 < tilesX && !joined[t + 1]) {
+      sides[availableSides++] = EAST;
+    }
+    if (tx > 0 && !joined[t - 1]) {
+      sides[availableSides++] = WEST;
+    }
+    if (availableSides == 0) {
+      stack.pop_back();
+      continue;
+    }
+
+    const Tile &tile = tiles[t];
+    int side = sides[random_.nextInt(availableSides)];
+    int x = tile.minX + random_.nextInt(tile.maxX - tile.minX);
+    int y = tile.minY + random_.nextInt(tile.maxY - tile.minY);
+    int next = t;
+    switch (side) {
       case NORTH:
-        removeWalls(i, j + 1);
+        y = tile.maxY - 1;
+        next = t + tilesX;
         break;
       case SOUTH:
-        removeWalls(i, j - 1);
+        y = tile.minY;
+        next = t - tilesX;
         break;
       case EAST:
-        removeWalls(i + 1, j);
+        x = tile.maxX - 1;
+        next = t + 1;
         break;
       case WEST:
-        removeWalls(i - 1, j);
-        break;
-      default:
+        x = tile.minX;
+        next = t - 1;
         break;
     }
+    removeWall(getCellIndex(x, y), side);
+    joined[next] = true;
+    stack.push_back(next);
   }
-
-  return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -250,8 +733,61 @@ int Quest::removeWalls(int i, int j) {
 //     Outputs: None.
 //------------------------------------------------------------------------------
 void Quest::setStartAndFinish() {
-  startX_ = rand() % width_;
-  finishX_ = rand() % width_;
+  startX_ = random_.nextInt(width_);
+  finishX_ = random_.nextInt(width_);
+}
+
+//------------------------------------------------------------------------------
+//      Method: makeInfinite
+//
+// Description: Switches the quest to an unbounded, chunked world generated
+//              lazily around the player (see 'World'). The quest's own maze
+//              and NPCs are no longer drawn or used for collisions, and the
+//              quest has no finish.
+//
+//      Inputs: viewDistance - Number of chunks kept loaded in each direction
+//                             beyond the one the player occupies.
+//
+//     Outputs: A pointer to the newly created World.
+//------------------------------------------------------------------------------
+World *Quest::makeInfinite(int viewDistance) {
+  if (world_) {
+    delete world_;
+  }
+
+  return world_ = new World(this, seed_, viewDistance);
+}
+
+//------------------------------------------------------------------------------
+//      Method: bakeLighting
+//
+// Description: Bakes the maze's ambient occlusion and torch light (see
+//              'MazeLighting') across worker threads into a lightmap that its
+//              meshes sample from then on. Any meshes already built are
+//              rebuilt. Meant to be called once, right after the quest is
+//              generated or loaded; kept up to date via 'setWall'.
+//
+//      Inputs: nThreads - Number of worker threads (0 to use all cores).
+//
+//     Outputs: The number of torches placed.
+//------------------------------------------------------------------------------
+int Quest::bakeLighting(int nThreads) {
+  if (!lighting_) {
+    lighting_ = new MazeLighting();
+  }
+
+  int nTorches = lighting_->bake(this, nThreads);
+  for (int i = 0; i < meshes_.size(); ++i) {
+    buildMesh(meshes_[i]->getMinX(), meshes_[i]->getMinY());
+  }
+  if (visibility_) {
+    visibility_->invalidate();
+  }
+  if (overview_) {
+    overview_->invalidate();
+  }
+
+  return nTorches;
 }
 
 //------------------------------------------------------------------------------
@@ -277,6 +813,10 @@ Character *Quest::setPlayer(Character *player) {
 //     Outputs: The newly assigned perspective value.
 //------------------------------------------------------------------------------
 int Quest::setPerspective(int perspective) {
+  if (overview_) {
+    overview_->invalidate();  // its block visibility belongs to the old view
+  }
+
   return perspective_ = perspective;
 }
 
@@ -294,6 +834,19 @@ int Quest::getPerspective() const {
   return perspective_;
 }
 
+//------------------------------------------------------------------------------
+//      Method: getQuestNo
+//
+// Description: Returns the quest's number.
+//
+//      Inputs: None.
+//
+//     Outputs: Integer representing the quest.
+//------------------------------------------------------------------------------
+int Quest::getQuestNo() const {
+  return questNo_;
+}
+
 //------------------------------------------------------------------------------
 //      Method: getWidth
 //
@@ -346,6 +899,281 @@ int Quest::getFinishX() const {
   return finishX_;
 }
 
+//------------------------------------------------------------------------------
+//      Method: isInfinite
+//
+// Description: Determines whether the quest takes place in an unbounded,
+//              chunked world (see 'makeInfinite').
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if the quest is infinite, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool Quest::isInfinite() const {
+  return world_ != NULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWorld
+//
+// Description: Returns the quest's chunked world, if any.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the World, or NULL if the quest is finite.
+//------------------------------------------------------------------------------
+World *Quest::getWorld() const {
+  return world_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getPathfinder
+//
+// Description: Returns the quest's pathfinder, preprocessing the maze to build
+//              it on first use (see 'Pathfinder'). It is kept up to date as
+//              walls change via 'setWall'.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the quest's pathfinder.
+//------------------------------------------------------------------------------
+Pathfinder *Quest::getPathfinder() {
+  if (!pathfinder_) {
+    pathfinder_ = new Pathfinder(this);
+  }
+
+  return pathfinder_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getLighting
+//
+// Description: Returns the maze's baked lighting (see 'bakeLighting').
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the quest's lighting, or NULL if it has not been
+//              baked.
+//------------------------------------------------------------------------------
+const MazeLighting *Quest::getLighting() const {
+  return lighting_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getSeed
+//
+// Description: Returns the seed from which the quest was generated.
+//
+//      Inputs: None.
+//
+//     Outputs: The quest's seed.
+//------------------------------------------------------------------------------
+uint64_t Quest::getSeed() const {
+  return seed_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getRandom
+//
+// Description: Returns the quest's random number generator, from which all of
+//              its random choices (maze layout, NPC placement, etc.) are drawn.
+//
+//      Inputs: None.
+//
+//     Outputs: A reference to the quest's Random object.
+//------------------------------------------------------------------------------
+Random &Quest::getRandom() {
+  return random_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getGenerationRate
+//
+// Description: Returns the maze generation throughput achieved by the most
+//              recent call to 'removeWalls', 'removeWallsInParallel', or
+//              'removeWallsByRows'.
+//
+//      Inputs: None.
+//
+//     Outputs: Cells carved per second, or 0.0 if no timing is available.
+//------------------------------------------------------------------------------
+double Quest::getGenerationRate() const {
+  if (generationTime_ <= 0.0) {
+    return 0.0;
+  }
+
+  return width_ * (double) height_ / generationTime_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCellIndex
+//
+// Description: Returns the index within 'cells_' of the cell at a given set of
+//              coordinates.
+//
+//      Inputs: x, y - Coordinates of the cell of interest.
+//
+//     Outputs: The cell's index, or -1 if the coordinates are out of bounds.
+//------------------------------------------------------------------------------
+int Quest::getCellIndex(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return -1;
+  }
+
+  return x + y * width_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCell
+//
+// Description: Returns a read-only reference to the cell at a given index.
+//
+//      Inputs: cellIndex - Index of the cell of interest (see 'getCellIndex').
+//
+//     Outputs: A reference to the cell.
+//------------------------------------------------------------------------------
+const Cell &Quest::getCell(int cellIndex) const {
+  return cells_[cellIndex];
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNeighborIndex
+//
+// Description: Returns the index of the cell adjoining a given cell on a given
+//              side.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              side      - Integer representing the side of interest (NORTH,
+//                          SOUTH, EAST, or WEST).
+//
+//     Outputs: The neighbor's index, or -1 if no neighbor exists there.
+//------------------------------------------------------------------------------
+int Quest::getNeighborIndex(int cellIndex, int side) const {
+  int x = cellIndex % width_;
+  int y = cellIndex / width_;
+
+  switch (side) {
+    case NORTH:
+      return y + 1 < height_ ? cellIndex + width_ : -1;
+    case SOUTH:
+      return y > 0 ? cellIndex - width_ : -1;
+    case EAST:
+      return x + 1 < width_ ? cellIndex + 1 : -1;
+    case WEST:
+      return x > 0 ? cellIndex - 1 : -1;
+    default:
+      break;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getMaterial
+//
+// Description: Returns the texture assigned to one of the quest's materials.
+//
+//      Inputs: material - Integer representing the material of interest
+//                         (WALL_MATERIAL, FLOOR_MATERIAL, etc.).
+//
+//     Outputs: The material's texture number, or -1 if the material is
+//              invalid.
+//------------------------------------------------------------------------------
+int Quest::getMaterial(int material) const {
+  if (material < 0 || material >= NUM_MATERIALS) {
+    return -1;
+  }
+
+  return getTextureNo(materials_[material]);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getMaterialIndex
+//
+// Description: Returns the index (as passed to 'getTextureNo') of the texture
+//              assigned to one of the quest's materials. Unlike texture
+//              numbers, indices remain valid across runs, so they are what
+//              gets saved to quest files.
+//
+//      Inputs: material - Integer representing the material of interest
+//                         (WALL_MATERIAL, FLOOR_MATERIAL, etc.).
+//
+//     Outputs: The material's texture index, or -1 if the material is
+//              invalid.
+//------------------------------------------------------------------------------
+int Quest::getMaterialIndex(int material) const {
+  if (material < 0 || material >= NUM_MATERIALS) {
+    return -1;
+  }
+
+  return materials_[material];
+}
+
+//------------------------------------------------------------------------------
+//      Method: hasWallAt
+//
+// Description: Determines whether the cell at a given set of coordinates has a
+//              wall along a given side.
+//
+//      Inputs: x, y - Coordinates of the cell of interest.
+//              side - Integer representing the side of interest (NORTH,
+//                     SOUTH, EAST, WEST, TOP, or BOTTOM).
+//
+//     Outputs: Returns 'true' if a wall exists there (or the coordinates are
+//              out of bounds), 'false' otherwise.
+//------------------------------------------------------------------------------
+bool Quest::hasWallAt(int x, int y, int side) const {
+  int cellIndex = getCellIndex(x, y);
+
+  return cellIndex < 0 || cells_[cellIndex].hasWallAt(side);
+}
+
+//------------------------------------------------------------------------------
+//      Method: explore
+//
+// Description: Marks a given cell as explored by the player.
+//
+//      Inputs: x, y - Coordinates of the cell.
+//
+//     Outputs: Returns 'true' if the cell had not been explored before, 'false'
+//              if it had or lies outside the maze.
+//------------------------------------------------------------------------------
+bool Quest::explore(int x, int y) {
+  int cellIndex = getCellIndex(x, y);
+
+  if (cellIndex < 0) {
+    return false;
+  }
+  if (explored_.empty()) {
+    explored_.assign((cells_.size() + 63) / 64, 0);
+  }
+
+  uint64_t bit = (uint64_t) 1 << (cellIndex % 64);
+  if (explored_[cellIndex / 64] & bit) {
+    return false;
+  }
+  explored_[cellIndex / 64] |= bit;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isExplored
+//
+// Description: Determines whether a given cell has been explored by the
+//              player (see 'explore').
+//
+//      Inputs: x, y - Coordinates of the cell.
+//
+//     Outputs: Returns 'true' if the cell has been explored.
+//------------------------------------------------------------------------------
+bool Quest::isExplored(int x, int y) const {
+  int cellIndex = getCellIndex(x, y);
+
+  return cellIndex >= 0 && !explored_.empty() &&
+         (explored_[cellIndex / 64] >> (cellIndex % 64) & 1);
+}
+
 //------------------------------------------------------------------------------
 //      Method: isLegalPosition
 //
@@ -361,32 +1189,37 @@ int Quest::getFinishX() const {
 //     Outputs: Returns 'true' if the position is legal, 'false' otherwise.
 //------------------------------------------------------------------------------
 bool Quest::isLegalPosition(double x, double y, double radius) const {
+  if (world_) {
+    return world_->isLegalPosition(x, y, radius);
+  }
+
   int cellIndex = (int) x + ((int) y) * width_;
   double offsetX = x - (int) x;
   double offsetY = y - (int) y;
 
-  if (y < 0 || y > height_ || x < 0 || x > width_ || cellIndex < 0 ||
-      cellIndex > cells_.size()) {
+  if (y < 0 || y >= height_ || x < 0 || x >= width_) {
     return false;
   }
 
+  const Cell &cell = cells_[cellIndex];
+
   // test north wall
-  if (cells_[cellIndex]->hasWallAt(NORTH) && offsetY + radius > 1.0) {
+  if (cell.hasWallAt(NORTH) && offsetY + radius > 1.0) {
     return false;
   }
 
   // test south wall
-  if (cells_[cellIndex]->hasWallAt(SOUTH) && offsetY - radius < 0.0) {
+  if (cell.hasWallAt(SOUTH) && offsetY - radius < 0.0) {
     return false;
   }
 
   // test east wall
-  if (cells_[cellIndex]->hasWallAt(EAST) && offsetX + radius > 1.0) {
+  if (cell.hasWallAt(EAST) && offsetX + radius > 1.0) {
     return false;
   }
 
   // test west wall
-  if (cells_[cellIndex]->hasWallAt(WEST) && offsetX - radius < 0.0) {
+  if (cell.hasWallAt(WEST) && offsetX - radius < 0.0) {
     return false;
   }
 
@@ -400,28 +1233,304 @@ bool Quest::isLegalPosition(double x, double y, double radius) const {
 }
 
 //------------------------------------------------------------------------------
-//      Method: draw
+//      Method: getNumVisibleChunks
+//
+// Description: Returns the number of chunks (mesh blocks, or the infinite
+//              world's chunks) that passed frustum culling in the most recent
+//              'draw'.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of chunks drawn.
+//------------------------------------------------------------------------------
+int Quest::getNumVisibleChunks() const {
+  return nVisibleChunks_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumCulledChunks
+//
+// Description: Returns the number of non-empty chunks that were skipped by
+//              frustum culling in the most recent 'draw'.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of chunks culled.
+//------------------------------------------------------------------------------
+int Quest::getNumCulledChunks() const {
+  return nCulledChunks_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: act
 //
-// Description: Draws the quest environment and associated objects according to
-//              the current perspective.
+// Description: Executes one step of AI behavior for every NPC, including those
+//              of the infinite world's loaded chunks (the caller must then hold
+//              the world's mutex; see 'World::getMutex').
 //
 //      Inputs: None.
 //
 //     Outputs: None.
 //------------------------------------------------------------------------------
-void Quest::draw() {
-  for (int i = 0; i < width_; ++i) {
-    for (int j = 0; j < height_; ++j) {
-      int cellIndex = i + j * width_;
-      if (cellIndex < 0 || cellIndex > cells_.size()) {
-        continue;
+void Quest::act() {
+  for (size_t i = 0; i < characters_.size(); ++i) {
+    characters_[i]->act(player_);
+  }
+  if (world_) {
+    world_->act(player_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCharacters
+//
+// Description: Appends the current state of every NPC, in the same order as
+//              'act' updates them, to a given list.
+//
+//      Inputs: instances - The list to which the NPCs are appended.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::getCharacters(vector<CrowdInstance> &instances) const {
+  for (size_t i = 0; i < characters_.size(); ++i) {
+    instances.push_back(getCrowdInstance(characters_[i]));
+  }
+  if (world_) {
+    world_->getCharacters(instances);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: draw
+//
+// Description: Draws the quest environment and a given state of its characters
+//              according to the current perspective. The maze is drawn in
+//              chunks (blocks of MESH_BLOCK_SIZE x MESH_BLOCK_SIZE cells, or
+//              the infinite world's chunks), each of which is tested against
+//              the camera's view frustum (see 'Frustum'); culled chunks and the
+//              NPCs within them are not drawn. Visible chunks are submitted
+//              through a render queue, grouped by material and nearest first.
+//              In first-person perspective, only the cells visible from the
+//              player's cell (see 'Visibility') and the NPCs within them are
+//              drawn; their meshes are rebuilt only when the player changes
+//              cells. In third-person perspective, the static maze is rendered
+//              once into an offscreen cache (see 'OverviewCache') that is
+//              merely copied to the window each frame until a wall changes or
+//              the window is reshaped. Visible characters are drawn together
+//              as one crowd (see 'CrowdRenderer'). Characters are read only
+//              from the given state, never from the Character objects, which
+//              belong to the simulation thread (see 'Simulation').
+//
+//      Inputs: frame - The state of the player and NPCs to be drawn.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::draw(const Snapshot &frame) {
+  int textures[NUM_MATERIALS];
+
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    textures[m] = getMaterial(m);
+  }
+  if (!renderQueue_) {
+    renderQueue_ = new RenderQueue();
+    renderQueue_->setTextureArray(getTextureArray(), NUM_TEXTURES);
+    frustum_ = new Frustum();
+    crowd_ = new CrowdRenderer();
+    overview_ = new OverviewCache();
+  }
+  renderQueue_->clear();
+  crowd_->clear();
+  frustum_->extract();
+  if (world_) {
+    world_->update(frame.player.x, frame.player.y);
+    nVisibleChunks_ = world_->queueMeshes(*renderQueue_, *frustum_,
+                                          frame.player.x, frame.player.y);
+    nCulledChunks_ = world_->getNumLoadedChunks() - nVisibleChunks_;
+    renderQueue_->submit(perspective_, textures);
+    for (size_t i = 0; i < frame.characters.size(); ++i) {
+      if (world_->isVisible(frame.characters[i].x, frame.characters[i].y)) {
+        crowd_->add(frame.characters[i]);
+      }
+    }
+    if (perspective_ != FIRST_PERSON) {
+      crowd_->add(frame.player);
+    }
+    crowd_->draw();
+    return;
+  }
+  if (perspective_ == THIRD_PERSON) {
+    if (!overview_->isCurrent() && overview_->begin()) {
+      drawMaze(textures, frame.player);
+      overview_->end();
+    }
+    if (overview_->blit()) {
+      drawCharacters(frame);
+      return;
+    }
+  }
+  drawMaze(textures, frame.player);
+  drawCharacters(frame);
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawMaze
+//
+// Description: A private method that draws the (finite) maze's visible blocks
+//              and records which blocks were visible for 'drawCharacters'.
+//
+//      Inputs: textures - Array of NUM_MATERIALS texture numbers.
+//              viewer   - The player, whose position determines the visible
+//                         cells and the drawing order.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::drawMaze(const int *textures, const CrowdInstance &viewer) {
+  int blocksX = (width_ + MESH_BLOCK_SIZE - 1) / MESH_BLOCK_SIZE,
+      blocksY = (height_ + MESH_BLOCK_SIZE - 1) / MESH_BLOCK_SIZE;
+  vector<MazeMesh *> &blocks = (perspective_ == FIRST_PERSON) ?
+                               visibleMeshes_ : meshes_;
+  if (blocks.empty()) {
+    blocks.resize(blocksX * blocksY);
+    for (int i = 0; i < blocks.size(); ++i) {
+      blocks[i] = new MazeMesh();
+      if (perspective_ != FIRST_PERSON) {
+        buildMesh(i % blocksX * MESH_BLOCK_SIZE,
+                  i / blocksX * MESH_BLOCK_SIZE);
       }
-      cells_[cellIndex]->draw(i, j, perspective_);
     }
   }
-  vector<Character *>::iterator iter;
-  for (iter = characters_.begin(); iter < characters_.end(); ++iter) {
-    (*iter)->act(player_);
-    (*iter)->draw();
+  if (perspective_ == FIRST_PERSON) {
+    if (!visibility_) {
+      visibility_ = new Visibility(this);
+    }
+    if (visibility_->update((int) viewer.x, (int) viewer.y)) {
+      buildVisibleMeshes();
+    }
+  }
+  isBlockVisible_.assign(blocks.size(), false);
+  nVisibleChunks_ = 0;
+  nCulledChunks_ = 0;
+  for (int i = 0; i < blocks.size(); ++i) {
+    MazeMesh *mesh = blocks[i];
+    if (mesh->getNumFaces() == 0) {
+      continue;
+    }
+    if (frustum_->isBoxVisible(mesh->getMinX(), mesh->getMinY(), 0.0,
+                               mesh->getMaxX(), mesh->getMaxY(), 1.0)) {
+      renderQueue_->add(mesh, viewer.x, viewer.y);
+      isBlockVisible_[i] = true;
+      ++nVisibleChunks_;
+    } else {
+      ++nCulledChunks_;
+    }
+  }
+  renderQueue_->setLightmap(lighting_ ? lighting_->getLightmap() : 0);
+  renderQueue_->submit(perspective_, textures);
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawCharacters
+//
+// Description: A private method that draws the NPCs of a given state within
+//              the blocks (and, in first-person perspective, the cells) found
+//              visible by the most recent 'drawMaze', along with the player
+//              outside first-person perspective.
+//
+//      Inputs: frame - The state of the player and NPCs to be drawn.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::drawCharacters(const Snapshot &frame) {
+  for (size_t i = 0; i < frame.characters.size(); ++i) {
+    const CrowdInstance &character = frame.characters[i];
+    int x = (int) character.x,
+        y = (int) character.y,
+        block = getBlockIndex(x, y);
+    if (block >= 0 && block < isBlockVisible_.size() &&
+        isBlockVisible_[block] &&
+        (perspective_ != FIRST_PERSON ||
+         visibility_->isVisible(getCellIndex(x, y)))) {
+      crowd_->add(character);
+    }
+  }
+  if (perspective_ != FIRST_PERSON) {
+    crowd_->add(frame.player);
+  }
+  crowd_->draw();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getBlockIndex
+//
+// Description: A private method that returns the index of the mesh block of
+//              MESH_BLOCK_SIZE x MESH_BLOCK_SIZE cells containing a given cell.
+//
+//      Inputs: x, y - Coordinates of the cell of interest.
+//
+//     Outputs: The block's index (row-major), or -1 if the cell is outside the
+//              maze.
+//------------------------------------------------------------------------------
+int Quest::getBlockIndex(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return -1;
+  }
+
+  return x / MESH_BLOCK_SIZE +
+         y / MESH_BLOCK_SIZE * ((width_ + MESH_BLOCK_SIZE - 1) /
+                                MESH_BLOCK_SIZE);
+}
+
+//------------------------------------------------------------------------------
+//      Method: buildMesh
+//
+// Description: A private method that (re)builds the mesh of the block of
+//              MESH_BLOCK_SIZE x MESH_BLOCK_SIZE cells containing a given cell
+//              (see 'MazeMesh'). Its vertex buffer is uploaded when next drawn.
+//
+//      Inputs: x, y - Coordinates of a cell within the block of interest.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::buildMesh(int x, int y) {
+  int minX = x - x % MESH_BLOCK_SIZE,
+      minY = y - y % MESH_BLOCK_SIZE;
+
+  meshes_[getBlockIndex(x, y)]->build(
+    &cells_[getCellIndex(minX, minY)], width_,
+    min(MESH_BLOCK_SIZE, width_ - minX), min(MESH_BLOCK_SIZE, height_ - minY),
+    minX, minY, materials_, startX_, finishX_, height_ - 1, NULL, lighting_);
+}
+
+//------------------------------------------------------------------------------
+//      Method: buildVisibleMeshes
+//
+// Description: A private method that rebuilds the first-person meshes from the
+//              current visible set: each block overlapping the set's bounds
+//              gets the faces of its visible cells, and every other block is
+//              emptied.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Quest::buildVisibleMeshes() {
+  int blocksX = (width_ + MESH_BLOCK_SIZE - 1) / MESH_BLOCK_SIZE,
+      minX, minY, maxX, maxY;
+
+  visibility_->getBounds(minX, minY, maxX, maxY);
+  for (int i = 0; i < visibleMeshes_.size(); ++i) {
+    int x1 = max(minX, i % blocksX * MESH_BLOCK_SIZE),
+        y1 = max(minY, i / blocksX * MESH_BLOCK_SIZE),
+        x2 = min(maxX, (i % blocksX + 1) * MESH_BLOCK_SIZE),
+        y2 = min(maxY, (i / blocksX + 1) * MESH_BLOCK_SIZE);
+    if (x1 < x2 && y1 < y2) {
+      int cellIndex = getCellIndex(x1, y1);
+      visibleMeshes_[i]->build(&cells_[cellIndex], width_, x2 - x1, y2 - y1,
+                               x1, y1, materials_, startX_, finishX_,
+                               height_ - 1, visibility_->getMask() + cellIndex,
+                               lighting_);
+    } else if (visibleMeshes_[i]->getNumFaces() > 0) {
+      visibleMeshes_[i]->clear();
+    }
   }
 }
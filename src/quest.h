@@ -12,14 +12,43 @@ Description: Declaration of a 'Quest' class responsible for managing all
 #define QUEST_H_
 
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
 #include "main.h"
 #include "character.h"
 #include "cell.h"
+#include "eller.h"
+#include "random.h"
+#include "world.h"
+#include "questfile.h"
+#include "pathfinder.h"
+#include "mesh.h"
+#include "renderqueue.h"
+#include "visibility.h"
+#include "frustum.h"
+#include "crowd.h"
+#include "overview.h"
+#include "minimap.h"
+#include "lighting.h"
 
 using namespace std;
 
 class Cell;
 class Character;
+class World;
+class QuestFile;
+class Pathfinder;
+class MazeMesh;
+class RenderQueue;
+class Visibility;
+class Frustum;
+class CrowdRenderer;
+class OverviewCache;
+class Minimap;
+class MazeLighting;
+struct CrowdInstance;
+struct Snapshot;
 
 enum Perspective {
   FIRST_PERSON,
@@ -27,35 +56,98 @@ enum Perspective {
   NUM_PERSPECTIVES
 };
 
+enum MazeAlgorithm {
+  DEPTH_FIRST,  // recursive backtracker (parallel tiles for large mazes)
+  ROW_BY_ROW,   // Eller's algorithm (O(width) working memory)
+  NUM_MAZE_ALGORITHMS
+};
+
+enum Material {
+  WALL_MATERIAL,
+  FLOOR_MATERIAL,
+  CEILING_MATERIAL,
+  DOOR_MATERIAL,
+  NUM_MATERIALS
+};
+
 const int DEFAULT_QUEST_NO = 1;
 const int DEFAULT_MAZE_WIDTH = 26;
 const int DEFAULT_MAZE_HEIGHT = 19;
 const int DEFAULT_NUM_NPCS = 30;
 const int TEXTURE_OFFSET_PER_QUEST = 4;
 const int DEFAULT_PERSPECTIVE = FIRST_PERSON;
+const int DEFAULT_MAZE_ALGORITHM = DEPTH_FIRST;
+const int PARALLEL_GENERATION_MIN_CELLS = 1 << 20;
+const int PARALLEL_TILE_SIZE = 128;
+
+// A rectangular region of the maze carved independently of all others (see
+// 'Quest::removeWallsInParallel'), with its own random stream. Max
+// coordinates are exclusive.
+struct Tile {
+  int minX,
+      minY,
+      maxX,
+      maxY;
+  Random random;
+};
 
 class Quest {
  public:
   Quest(int questNo = DEFAULT_QUEST_NO,
         int width = DEFAULT_MAZE_WIDTH,
         int height = DEFAULT_MAZE_HEIGHT,
-        int perspective = DEFAULT_PERSPECTIVE);
+        int perspective = DEFAULT_PERSPECTIVE,
+        uint64_t seed = DEFAULT_SEED,
+        int nThreads = 0,
+        int algorithm = DEFAULT_MAZE_ALGORITHM);
+  Quest(const QuestFile &file, int perspective = DEFAULT_PERSPECTIVE);
   ~Quest();
-  void initialize(int questNo, int width, int height, int perspective);
+  void initialize(int questNo, int width, int height, int perspective,
+                  uint64_t seed = DEFAULT_SEED, int nThreads = 0,
+                  int algorithm = DEFAULT_MAZE_ALGORITHM);
+  void initialize(const QuestFile &file, int perspective);
+  int save(const char *filename) const;
   int initializeCells();
   int initializeCharacters();
-  int assignNeighbors(int x, int y);
+  int addCharacters(int nCharacters);
   int removeWalls(int x, int y);
+  int removeWallsInParallel(int nThreads);
+  int removeWallsByRows();
+  void removeWall(int cellIndex, int side);
+  int setWall(int x, int y, int side, bool present);
+  int removeRandomWall(int cellIndex, Tile &tile);
   void setStartAndFinish();
+  World *makeInfinite(int viewDistance);
+  int bakeLighting(int nThreads = 0);
   Character *setPlayer(Character *player);
   int setPerspective(int perspective);
   int getPerspective() const;
+  int getQuestNo() const;
   int getWidth() const;
   int getHeight() const;
   int getStartX() const;
   int getFinishX() const;
+  bool isInfinite() const;
+  World *getWorld() const;
+  Pathfinder *getPathfinder();
+  const MazeLighting *getLighting() const;
+  uint64_t getSeed() const;
+  Random &getRandom();
+  double getGenerationRate() const;
+  int getCellIndex(int x, int y) const;
+  const Cell &getCell(int cellIndex) const;
+  int getNeighborIndex(int cellIndex, int side) const;
+  int getMaterial(int material) const;
+  int getMaterialIndex(int material) const;
+  bool hasWallAt(int x, int y, int side) const;
+  bool explore(int x, int y);
+  bool isExplored(int x, int y) const;
   bool isLegalPosition(double x, double y, double radius) const;
-  void draw();
+  int getNumVisibleChunks() const;
+  int getNumCulledChunks() const;
+  void act();
+  void getCharacters(vector<CrowdInstance> &instances) const;
+  void draw(const Snapshot &frame);
  private:
   int questNo_,
       width_,
@@ -63,9 +155,36 @@ class Quest {
       startX_,
       finishX_,
       perspective_;
-  vector<Cell *> cells_;
+  uint64_t seed_;
+  Random random_;
+  double generationTime_;
+  vector<Cell> cells_;
+  int materials_[NUM_MATERIALS];
   Character *player_;
   vector<Character *> characters_;
+  World *world_;
+  Pathfinder *pathfinder_;
+  MazeLighting *lighting_;
+  vector<MazeMesh *> meshes_;
+  RenderQueue *renderQueue_;
+  Visibility *visibility_;
+  vector<MazeMesh *> visibleMeshes_;  // per block, faces of visible cells
+  Frustum *frustum_;
+  CrowdRenderer *crowd_;
+  OverviewCache *overview_;
+  vector<uint64_t> explored_;  // one bit per cell, row-major
+  vector<bool> isBlockVisible_;
+  int nVisibleChunks_,
+      nCulledChunks_;
+
+  int getBlockIndex(int x, int y) const;
+  void buildMesh(int x, int y);
+  void buildVisibleMeshes();
+  void drawMaze(const int *textures, const CrowdInstance &viewer);
+  void drawCharacters(const Snapshot &frame);
+  void carveTile(Tile &tile, int cellIndex, vector<int> &stack);
+  void carveTiles(vector<Tile> *tiles, atomic<int> *nextTile);
+  void stitchTiles(vector<Tile> &tiles, int tilesX, int tilesY);
 };
 
 #endif  // QUEST_H_
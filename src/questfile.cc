@@ -0,0 +1,408 @@
+/*******************************************************************************
+   Filename: questfile.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definitions of classes for writing the binary quest file format
+             ('QuestFileWriter') and for reading it in place via a read-only
+             memory mapping ('QuestFile'). See questfile.h for the layout.
+*******************************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "questfile.h"
+
+//------------------------------------------------------------------------------
+//      Method: initializeQuestFileHeader
+//
+// Description: Fills in the parts of a quest file header that follow from the
+//              format itself (magic number, version, and section offsets) for
+//              a quest of a given size. The remaining fields are zeroed for
+//              the caller to fill in.
+//
+//      Inputs: header        - The header to be initialized.
+//              width, height - Maze dimensions, measured in cells.
+//              numSpawns     - Number of NPC spawn records.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void initializeQuestFileHeader(QuestFileHeader &header, int width,
+                               int height, uint32_t numSpawns) {
+  uint64_t wallBytes = ((uint64_t) width * height +
+                        QUEST_FILE_CELLS_PER_BYTE - 1) /
+                       QUEST_FILE_CELLS_PER_BYTE;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, QUEST_FILE_MAGIC, sizeof(header.magic));
+  header.version = QUEST_FILE_VERSION;
+  header.headerSize = sizeof(QuestFileHeader);
+  header.width = width;
+  header.height = height;
+  header.numSpawns = numSpawns;
+  header.wallsOffset = sizeof(QuestFileHeader);
+  header.spawnsOffset = (header.wallsOffset + wallBytes + 7) & ~7ULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: QuestFile
+//
+// Description: Constructs a QuestFile object with no file open.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+QuestFile::QuestFile() {
+  data_ = NULL;
+  size_ = 0;
+  header_ = NULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~QuestFile
+//
+// Description: Destructs the QuestFile object, unmapping its file (if any).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+QuestFile::~QuestFile() {
+  close();
+}
+
+//------------------------------------------------------------------------------
+//      Method: open
+//
+// Description: Maps a given quest file into memory (read-only and shared, so
+//              several processes opening the same file share its pages) and
+//              validates its header, section bounds, texture indices, and NPC
+//              spawns. Nothing is parsed or copied: all accessors read the
+//              mapped bytes in place.
+//
+//      Inputs: filename - Path of the quest file.
+//
+//     Outputs: Returns 'true' if the file was opened successfully, 'false'
+//              otherwise.
+//------------------------------------------------------------------------------
+bool QuestFile::open(const char *filename) {
+  struct stat info;
+  int fd;
+
+  close();
+  fd = ::open(filename, O_RDONLY);
+  if (fd < 0) {
+    cerr << "Error: could not open \"" << filename << "\"." << endl;
+    return false;
+  }
+  if (fstat(fd, &info) < 0 || info.st_size < (off_t) sizeof(QuestFileHeader)) {
+    cerr << "Error: \"" << filename << "\" is not a quest file." << endl;
+    ::close(fd);
+    return false;
+  }
+  size_ = info.st_size;
+  data_ = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data_ == MAP_FAILED) {
+    cerr << "Error: could not map \"" << filename << "\"." << endl;
+    data_ = NULL;
+    size_ = 0;
+    return false;
+  }
+
+  const QuestFileHeader *header = (const QuestFileHeader *) data_;
+  uint64_t nCells = (uint64_t) header->width * header->height;
+  bool valid =
+    memcmp(header->magic, QUEST_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+    header->version == QUEST_FILE_VERSION &&
+    header->headerSize == sizeof(QuestFileHeader) &&
+    header->width > 0 && header->height > 0 &&
+    header->startX >= 0 && header->startX < header->width &&
+    header->finishX >= 0 && header->finishX < header->width &&
+    header->wallsOffset >= sizeof(QuestFileHeader) &&
+    header->wallsOffset + (nCells + QUEST_FILE_CELLS_PER_BYTE - 1) /
+      QUEST_FILE_CELLS_PER_BYTE <= header->spawnsOffset &&
+    header->spawnsOffset % 8 == 0 &&
+    header->spawnsOffset + (uint64_t) header->numSpawns *
+      sizeof(QuestFileSpawn) <= size_;
+  if (!valid) {
+    cerr << "Error: \"" << filename << "\" is not a valid version "
+         << QUEST_FILE_VERSION << " quest file." << endl;
+    close();
+    return false;
+  }
+
+  // values used as indices elsewhere must be in range
+  for (int m = 0; m < QUEST_FILE_NUM_TEXTURES; ++m) {
+    if (header->textures[m] < 0 || header->textures[m] >= NUM_TEXTURES) {
+      cerr << "Error: \"" << filename << "\" has an invalid texture index ("
+           << header->textures[m] << ")." << endl;
+      close();
+      return false;
+    }
+  }
+  const QuestFileSpawn *spawns =
+    (const QuestFileSpawn *) ((const char *) data_ + header->spawnsOffset);
+  for (uint32_t i = 0; i < header->numSpawns; ++i) {
+    if (spawns[i].type < 0 || spawns[i].type >= NUM_CHARACTER_TYPES ||
+        !(spawns[i].x >= 0.0f && spawns[i].x <= header->width) ||
+        !(spawns[i].y >= 0.0f && spawns[i].y <= header->height)) {
+      cerr << "Error: \"" << filename << "\" has an invalid NPC spawn (record "
+           << i << ")." << endl;
+      close();
+      return false;
+    }
+  }
+  header_ = header;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: close
+//
+// Description: Unmaps the current file, if any. Pointers previously returned
+//              by the accessors become invalid.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void QuestFile::close() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+  data_ = NULL;
+  size_ = 0;
+  header_ = NULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isOpen
+//
+// Description: Determines whether a valid quest file is currently mapped.
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if a file is open, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestFile::isOpen() const {
+  return header_ != NULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getHeader
+//
+// Description: Returns the mapped file's header.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the header, or NULL if no file is open.
+//------------------------------------------------------------------------------
+const QuestFileHeader *QuestFile::getHeader() const {
+  return header_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWalls
+//
+// Description: Returns the mapped file's packed wall bits.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the wall bits, or NULL if no file is open.
+//------------------------------------------------------------------------------
+const unsigned char *QuestFile::getWalls() const {
+  if (!header_) {
+    return NULL;
+  }
+
+  return (const unsigned char *) data_ + header_->wallsOffset;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getSpawns
+//
+// Description: Returns the mapped file's NPC spawn records.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the first of 'numSpawns' records, or NULL if no
+//              file is open.
+//------------------------------------------------------------------------------
+const QuestFileSpawn *QuestFile::getSpawns() const {
+  if (!header_) {
+    return NULL;
+  }
+
+  return (const QuestFileSpawn *) ((const char *) data_ +
+                                   header_->spawnsOffset);
+}
+
+//------------------------------------------------------------------------------
+//      Method: hasWallAt
+//
+// Description: Determines, directly from the mapped wall bits, whether the
+//              cell at a given set of coordinates has a wall along a given
+//              side.
+//
+//      Inputs: x, y - Coordinates of the cell of interest.
+//              side - Integer representing the side of interest (NORTH,
+//                     SOUTH, EAST, WEST, TOP, or BOTTOM).
+//
+//     Outputs: Returns 'true' if a wall exists there (or the coordinates are
+//              out of bounds or no file is open), 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestFile::hasWallAt(int x, int y, int side) const {
+  if (!header_ || x < 0 || y < 0 || x >= header_->width ||
+      y >= header_->height) {
+    return true;
+  }
+
+  switch (side) {
+    case SOUTH:
+      return y == 0 || hasWallAt(x, y - 1, NORTH);
+    case WEST:
+      return x == 0 || hasWallAt(x - 1, y, EAST);
+    case NORTH:
+    case EAST: {
+      uint64_t i = x + (uint64_t) y * header_->width;
+      int bits = getWalls()[i / QUEST_FILE_CELLS_PER_BYTE] >>
+                 (i % QUEST_FILE_CELLS_PER_BYTE * 2);
+      return (bits & (side == NORTH ? 1 : 2)) != 0;
+    }
+    default:
+      break;
+  }
+
+  return true;  // floors and ceilings are never removed
+}
+
+//------------------------------------------------------------------------------
+//      Method: QuestFileWriter
+//
+// Description: Constructs a QuestFileWriter object with no file open.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+QuestFileWriter::QuestFileWriter() {
+  file_ = NULL;
+  nRows_ = 0;
+  pending_ = 0;
+  nPending_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~QuestFileWriter
+//
+// Description: Destructs the QuestFileWriter object, closing its file (if any)
+//              without completing it.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+QuestFileWriter::~QuestFileWriter() {
+  if (file_) {
+    fclose(file_);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: open
+//
+// Description: Creates a quest file and writes its header. Rows must then be
+//              written in order with 'writeRow' (from y = 0), followed by a
+//              call to 'finish'.
+//
+//      Inputs: filename - Path of the file to be created.
+//              header   - The complete header (see
+//                         'initializeQuestFileHeader').
+//
+//     Outputs: Returns 'true' if successful, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestFileWriter::open(const char *filename,
+                           const QuestFileHeader &header) {
+  file_ = fopen(filename, "wb");
+  if (!file_) {
+    cerr << "Error: could not open \"" << filename << "\"." << endl;
+    return false;
+  }
+  header_ = header;
+  nRows_ = 0;
+  pending_ = 0;
+  nPending_ = 0;
+  buffer_.reserve(header_.width / QUEST_FILE_CELLS_PER_BYTE + 1);
+
+  return fwrite(&header_, sizeof(header_), 1, file_) == 1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: writeRow
+//
+// Description: Packs the NORTH and EAST walls of a row of cells and appends
+//              them to the file. Memory use is proportional to the row width,
+//              so rows can be streamed straight from a generator.
+//
+//      Inputs: row - Array of 'width' cells.
+//
+//     Outputs: Returns 'true' if successful, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestFileWriter::writeRow(const Cell *row) {
+  if (!file_ || nRows_ >= header_.height) {
+    return false;
+  }
+
+  buffer_.clear();
+  for (int x = 0; x < header_.width; ++x) {
+    int bits = (row[x].hasWallAt(NORTH) ? 1 : 0) |
+               (row[x].hasWallAt(EAST) ? 2 : 0);
+    pending_ |= bits << (nPending_ * 2);
+    if (++nPending_ == QUEST_FILE_CELLS_PER_BYTE) {
+      buffer_.push_back(pending_);
+      pending_ = 0;
+      nPending_ = 0;
+    }
+  }
+  if (++nRows_ == header_.height && nPending_ > 0) {
+    buffer_.push_back(pending_);
+  }
+
+  return buffer_.empty() ||
+         fwrite(&buffer_[0], 1, buffer_.size(), file_) == buffer_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: finish
+//
+// Description: Writes the NPC spawn records (padded to their 8-byte aligned
+//              offset) and closes the file.
+//
+//      Inputs: spawns - Array of 'numSpawns' spawn records.
+//
+//     Outputs: Returns 'true' if the complete file was written successfully,
+//              'false' otherwise.
+//------------------------------------------------------------------------------
+bool QuestFileWriter::finish(const QuestFileSpawn *spawns) {
+  if (!file_ || nRows_ != header_.height) {
+    return false;
+  }
+
+  bool success = true;
+  long position = ftell(file_);
+  while (success && (uint64_t) position++ < header_.spawnsOffset) {
+    success = fputc(0, file_) != EOF;
+  }
+  if (success && header_.numSpawns > 0) {
+    success = fwrite(spawns, sizeof(QuestFileSpawn), header_.numSpawns,
+                     file_) == header_.numSpawns;
+  }
+  success = fclose(file_) == 0 && success;
+  file_ = NULL;
+
+  return success;
+}
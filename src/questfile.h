@@ -0,0 +1,99 @@
+/*******************************************************************************
+   Filename: questfile.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declarations of a compact, versioned binary quest file format and
+             of classes for writing it ('QuestFileWriter') and for reading it
+             in place via a read-only memory mapping ('QuestFile').
+
+             The format is a load cache, not a runtime store: a Quest decodes
+             the mapped wall bits into its own cell grid (which also holds
+             per-cell state, and whose walls may change during play) in one
+             linear pass with no parsing, after which the file may be closed.
+
+             Layout (little-endian): a QuestFileHeader, then two wall bits per
+             cell (bit 0: NORTH, bit 1: EAST; cells row-major from (0, 0),
+             four cells per byte, low bits first), then, at the next 8-byte
+             boundary, 'numSpawns' QuestFileSpawn records. SOUTH and WEST walls
+             are those of the neighboring cells; outer walls always exist.
+*******************************************************************************/
+
+#ifndef QUESTFILE_H_
+#define QUESTFILE_H_
+
+#include <stdint.h>
+#include <cstdio>
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Cell;
+
+const char QUEST_FILE_MAGIC[4] = {'H', 'Q', 'S', 'T'};
+const uint16_t QUEST_FILE_VERSION = 2;
+const int QUEST_FILE_CELLS_PER_BYTE = 4;
+const int QUEST_FILE_NUM_TEXTURES = 4;  // one per Material
+
+struct QuestFileHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t headerSize;
+  int32_t questNo;
+  int32_t width;
+  int32_t height;
+  int32_t startX;
+  int32_t finishX;
+  int32_t textures[QUEST_FILE_NUM_TEXTURES];  // texture index per material
+  uint32_t numSpawns;
+  uint64_t wallsOffset;
+  uint64_t spawnsOffset;
+  uint64_t seed;
+  uint64_t sourceHash;  // hash of the layout compiled into it (0 if none)
+};
+
+struct QuestFileSpawn {
+  int32_t type;
+  float x,
+        y,
+        rotation;
+};
+
+class QuestFile {
+ public:
+  QuestFile();
+  ~QuestFile();
+  bool open(const char *filename);
+  void close();
+  bool isOpen() const;
+  const QuestFileHeader *getHeader() const;
+  const unsigned char *getWalls() const;
+  const QuestFileSpawn *getSpawns() const;
+  bool hasWallAt(int x, int y, int side) const;
+ private:
+  void *data_;
+  size_t size_;
+  const QuestFileHeader *header_;
+};
+
+class QuestFileWriter {
+ public:
+  QuestFileWriter();
+  ~QuestFileWriter();
+  bool open(const char *filename, const QuestFileHeader &header);
+  bool writeRow(const Cell *row);
+  bool finish(const QuestFileSpawn *spawns);
+ private:
+  FILE *file_;
+  QuestFileHeader header_;
+  vector<unsigned char> buffer_;
+  int nRows_;
+  unsigned char pending_;
+  int nPending_;
+};
+
+void initializeQuestFileHeader(QuestFileHeader &header, int width,
+                               int height, uint32_t numSpawns);
+
+#endif  // QUESTFILE_H_
@@ -0,0 +1,159 @@
+/*******************************************************************************
+   Filename: random.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Random' class, a small, fast, explicitly seeded
+             pseudorandom number generator (xoshiro256**) that can be split
+             into independent streams for use on separate threads.
+*******************************************************************************/
+
+#include "random.h"
+
+//------------------------------------------------------------------------------
+//      Method: rotateLeft
+//
+// Description: Rotates a 64-bit value left by a given number of bits.
+//
+//      Inputs: x - The value to be rotated.
+//              k - Number of bits (1 to 63).
+//
+//     Outputs: The rotated value.
+//------------------------------------------------------------------------------
+static inline uint64_t rotateLeft(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+//------------------------------------------------------------------------------
+//      Method: Random
+//
+// Description: Constructs a Random object (via the 'seed' method) from a given
+//              seed.
+//
+//      Inputs: seed - Any 64-bit value.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Random::Random(uint64_t seed) {
+  this->seed(seed);
+}
+
+//------------------------------------------------------------------------------
+//      Method: seed
+//
+// Description: Resets the generator's state from a given seed, expanded with
+//              SplitMix64 so that similar seeds still yield unrelated
+//              sequences. Identical seeds always yield identical sequences.
+//
+//      Inputs: seed - Any 64-bit value.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Random::seed(uint64_t seed) {
+  for (int i = 0; i < 4; ++i) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    state_[i] = z ^ (z >> 31);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: next
+//
+// Description: Advances the generator and returns its next output.
+//
+//      Inputs: None.
+//
+//     Outputs: A uniformly distributed 64-bit value.
+//------------------------------------------------------------------------------
+uint64_t Random::next() {
+  uint64_t result = rotateLeft(state_[1] * 5, 7) * 9;
+  uint64_t t = state_[1] << 17;
+
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+  state_[2] ^= t;
+  state_[3] = rotateLeft(state_[3], 45);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//      Method: nextInt
+//
+// Description: Returns a pseudorandom integer in the range [0, n), using a
+//              multiply and shift rather than a modulo.
+//
+//      Inputs: n - Exclusive upper bound (must be positive).
+//
+//     Outputs: An integer from 0 to n - 1.
+//------------------------------------------------------------------------------
+int Random::nextInt(int n) {
+  return (int) (((next() >> 32) * (uint64_t) n) >> 32);
+}
+
+//------------------------------------------------------------------------------
+//      Method: nextDouble
+//
+// Description: Returns a pseudorandom real number in the range [0, 1).
+//
+//      Inputs: None.
+//
+//     Outputs: A double from 0.0 up to (but not including) 1.0.
+//------------------------------------------------------------------------------
+double Random::nextDouble() {
+  return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: split
+//
+// Description: Returns an independent stream for use elsewhere (e.g., on
+//              another thread). The returned generator continues this one's
+//              sequence, while this one jumps 2^128 outputs ahead, so the two
+//              never overlap in practice. Splitting is deterministic: the same
+//              sequence of calls always yields the same streams.
+//
+//      Inputs: None.
+//
+//     Outputs: A new Random object.
+//------------------------------------------------------------------------------
+Random Random::split() {
+  Random stream = *this;
+
+  jump();
+
+  return stream;
+}
+
+//------------------------------------------------------------------------------
+//      Method: jump
+//
+// Description: A private method that advances the generator by 2^128 outputs.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Random::jump() {
+  static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                  0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+  uint64_t s[4] = {0, 0, 0, 0};
+
+  for (int i = 0; i < 4; ++i) {
+    for (int b = 0; b < 64; ++b) {
+      if (JUMP[i] & (1ULL << b)) {
+        for (int j = 0; j < 4; ++j) {
+          s[j] ^= state_[j];
+        }
+      }
+      next();
+    }
+  }
+  for (int j = 0; j < 4; ++j) {
+    state_[j] = s[j];
+  }
+}
@@ -0,0 +1,32 @@
+/*******************************************************************************
+   Filename: random.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Random' class, a small, fast, explicitly seeded
+             pseudorandom number generator (xoshiro256**) that can be split
+             into independent streams for use on separate threads.
+*******************************************************************************/
+
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+
+const uint64_t DEFAULT_SEED = 1;
+
+class Random {
+ public:
+  Random(uint64_t seed = DEFAULT_SEED);
+  void seed(uint64_t seed);
+  uint64_t next();
+  int nextInt(int n);
+  double nextDouble();
+  Random split();
+ private:
+  uint64_t state_[4];
+
+  void jump();
+};
+
+#endif  // RANDOM_H_
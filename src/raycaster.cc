@@ -0,0 +1,730 @@
+/*******************************************************************************
+   Filename: raycaster.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Raycaster' class, which renders the first-person
+             view of a finite maze in software by casting one ray per column.
+*******************************************************************************/
+
+#include <cstdio>
+#include <algorithm>
+#include "raycaster.h"
+#include "simulation.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i IntLanes;
+const int RAYCAST_LANES = 8;
+#else
+#include <emmintrin.h>
+typedef __m128i IntLanes;
+const int RAYCAST_LANES = 4;
+#endif
+
+const uint32_t OPAQUE_ALPHA = 0xff000000;
+
+//------------------------------------------------------------------------------
+//      Method: getTexel
+//
+// Description: A static helper that reads one pixel of a texture as RGBA.
+//
+//      Inputs: texture - The texture of interest.
+//              offset  - Byte offset of the pixel within the texture.
+//
+//     Outputs: The pixel, packed as 0xAABBGGRR (i.e., RGBA bytes in memory).
+//------------------------------------------------------------------------------
+static inline uint32_t getTexel(const RaycastTexture &texture, int offset) {
+  const unsigned char *pixel = texture.pixels + offset;
+
+  return pixel[texture.red] | (pixel[texture.green] << 8) |
+         (pixel[texture.blue] << 16) | OPAQUE_ALPHA;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getTexelOffsets
+//
+// Description: A static helper that finds, for RAYCAST_LANES consecutive
+//              columns of one row of the floor or ceiling, the byte offsets of
+//              the texels seen. The texture repeats once per cell.
+//
+//      Inputs: x, y         - World coordinates seen by the first column.
+//              stepX, stepY - Change in those coordinates per column.
+//              texture      - The floor or ceiling texture.
+//              offsets      - Receives RAYCAST_LANES byte offsets (must be
+//                             aligned to the SIMD width).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+static inline void getTexelOffsets(float x, float y, float stepX, float stepY,
+                                   const RaycastTexture &texture,
+                                   int *offsets) {
+#if defined(__AVX2__)
+  __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7),
+         xs = _mm256_add_ps(_mm256_set1_ps(x),
+                            _mm256_mul_ps(lanes, _mm256_set1_ps(stepX))),
+         ys = _mm256_add_ps(_mm256_set1_ps(y),
+                            _mm256_mul_ps(lanes, _mm256_set1_ps(stepY))),
+         width = _mm256_set1_ps((float) texture.width),
+         height = _mm256_set1_ps((float) texture.height);
+
+  // the fractions of a cell, scaled to texels (clamped in case of rounding)
+  xs = _mm256_mul_ps(_mm256_sub_ps(xs, _mm256_floor_ps(xs)), width);
+  ys = _mm256_mul_ps(_mm256_sub_ps(ys, _mm256_floor_ps(ys)), height);
+  xs = _mm256_min_ps(_mm256_floor_ps(xs),
+                     _mm256_sub_ps(width, _mm256_set1_ps(1.0f)));
+  ys = _mm256_min_ps(_mm256_floor_ps(ys),
+                     _mm256_sub_ps(height, _mm256_set1_ps(1.0f)));
+
+  // exact in single precision for textures of up to 4 million bytes
+  __m256 offset = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(ys, width), xs),
+                                _mm256_set1_ps((float) texture.components));
+  _mm256_store_si256((__m256i *) offsets, _mm256_cvttps_epi32(offset));
+#else
+  __m128 lanes = _mm_setr_ps(0, 1, 2, 3),
+         one = _mm_set1_ps(1.0f),
+         xs = _mm_add_ps(_mm_set1_ps(x),
+                         _mm_mul_ps(lanes, _mm_set1_ps(stepX))),
+         ys = _mm_add_ps(_mm_set1_ps(y),
+                         _mm_mul_ps(lanes, _mm_set1_ps(stepY))),
+         width = _mm_set1_ps((float) texture.width),
+         height = _mm_set1_ps((float) texture.height);
+
+  // SSE2 has no floor: truncate, then correct where truncation rounded up
+  __m128 truncatedX = _mm_cvtepi32_ps(_mm_cvttps_epi32(xs)),
+         truncatedY = _mm_cvtepi32_ps(_mm_cvttps_epi32(ys));
+  truncatedX = _mm_sub_ps(truncatedX,
+                          _mm_and_ps(_mm_cmpgt_ps(truncatedX, xs), one));
+  truncatedY = _mm_sub_ps(truncatedY,
+                          _mm_and_ps(_mm_cmpgt_ps(truncatedY, ys), one));
+
+  // the fractions of a cell, scaled to texels (clamped in case of rounding),
+  // are positive, so truncation now serves as floor
+  xs = _mm_mul_ps(_mm_sub_ps(xs, truncatedX), width);
+  ys = _mm_mul_ps(_mm_sub_ps(ys, truncatedY), height);
+  xs = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(xs)),
+                  _mm_sub_ps(width, one));
+  ys = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(ys)),
+                  _mm_sub_ps(height, one));
+
+  // exact in single precision for textures of up to 4 million bytes
+  __m128 offset = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ys, width), xs),
+                             _mm_set1_ps((float) texture.components));
+  _mm_store_si128((__m128i *) offsets, _mm_cvttps_epi32(offset));
+#endif
+}
+
+//------------------------------------------------------------------------------
+//      Method: getRowMask
+//
+// Description: A static helper that flags which of RAYCAST_LANES consecutive
+//              columns show the floor (or ceiling) in a given row.
+//
+//      Inputs: limits  - Per column, the first row of the wall (for the floor)
+//                        or the first row above it (for the ceiling).
+//              row     - The row of interest.
+//              isFloor - 'true' for the floor, 'false' for the ceiling.
+//
+//     Outputs: A mask with every bit of a lane set where that column shows
+//              the floor (or ceiling).
+//------------------------------------------------------------------------------
+static inline IntLanes getRowMask(const int *limits, int row, bool isFloor) {
+#if defined(__AVX2__)
+  __m256i rows = _mm256_loadu_si256((const __m256i *) limits);
+
+  return isFloor ? _mm256_cmpgt_epi32(rows, _mm256_set1_epi32(row)) :
+                   _mm256_cmpgt_epi32(_mm256_set1_epi32(row + 1), rows);
+#else
+  __m128i rows = _mm_loadu_si128((const __m128i *) limits);
+
+  return isFloor ? _mm_cmpgt_epi32(rows, _mm_set1_epi32(row)) :
+                   _mm_cmpgt_epi32(_mm_set1_epi32(row + 1), rows);
+#endif
+}
+
+//------------------------------------------------------------------------------
+//      Method: isAnyLaneSet
+//
+// Description: A static helper that determines whether a mask flags any lane.
+//
+//      Inputs: mask - A mask from 'getRowMask'.
+//
+//     Outputs: Returns 'true' if any lane is flagged.
+//------------------------------------------------------------------------------
+static inline bool isAnyLaneSet(IntLanes mask) {
+#if defined(__AVX2__)
+  return _mm256_movemask_epi8(mask) != 0;
+#else
+  return _mm_movemask_epi8(mask) != 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//      Method: blendLanes
+//
+// Description: A static helper that overwrites the flagged pixels among
+//              RAYCAST_LANES consecutive pixels of a row.
+//
+//      Inputs: destination - The row's first pixel of interest.
+//              texels      - RAYCAST_LANES new pixels (must be aligned to the
+//                            SIMD width).
+//              mask        - A mask from 'getRowMask'.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+static inline void blendLanes(uint32_t *destination, const uint32_t *texels,
+                              IntLanes mask) {
+#if defined(__AVX2__)
+  __m256i old = _mm256_loadu_si256((const __m256i *) destination),
+          fresh = _mm256_load_si256((const __m256i *) texels);
+
+  _mm256_storeu_si256((__m256i *) destination,
+                      _mm256_blendv_epi8(old, fresh, mask));
+#else
+  __m128i old = _mm_loadu_si128((const __m128i *) destination),
+          fresh = _mm_load_si128((const __m128i *) texels);
+
+  _mm_storeu_si128((__m128i *) destination,
+                   _mm_or_si128(_mm_and_si128(mask, fresh),
+                                _mm_andnot_si128(mask, old)));
+#endif
+}
+
+//------------------------------------------------------------------------------
+//      Method: compareSprites
+//
+// Description: A static helper that orders sprites from far to near.
+//
+//      Inputs: a, b - The sprites to be compared.
+//
+//     Outputs: Returns 'true' if 'a' is farther than 'b'.
+//------------------------------------------------------------------------------
+static bool compareSprites(const RaycastSprite &a, const RaycastSprite &b) {
+  return a.depth > b.depth;
+}
+
+//------------------------------------------------------------------------------
+//      Method: Raycaster
+//
+// Description: Constructs a Raycaster with an empty frame.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Raycaster::Raycaster() {
+  width_ = 0;
+  height_ = 0;
+  stride_ = 0;
+  quest_ = NULL;
+  eyeX_ = 0.0f;
+  eyeY_ = 0.0f;
+  eyeZ_ = 0.0f;
+  forwardX_ = 1.0f;
+  forwardY_ = 0.0f;
+  focalLength_ = 1.0f;
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    textures_[m].pixels = NULL;
+  }
+  nextStrip_ = 0;
+  frameNo_ = 0;
+  nHelpers_ = 0;
+  nBusyHelpers_ = 0;
+  isStopping_ = false;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~Raycaster
+//
+// Description: Destructs the Raycaster, stopping its worker threads.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Raycaster::~Raycaster() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    isStopping_ = true;
+  }
+  isFrameReady_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].join();
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: render
+//
+// Description: Renders a finite quest, as seen by the player in a given frame
+//              through the same perspective projection as the OpenGL renderer
+//              (see 'reshape'), using the quest's textures (see
+//              'getTextureImage'). The frame is split among worker threads by
+//              strips of columns; workers are started as needed and kept for
+//              later frames (see 'runWorker').
+//
+//      Inputs: quest         - The quest to be rendered (not infinite).
+//              frame         - The state to be rendered.
+//              width, height - Frame size, in pixels.
+//              nThreads      - Number of threads to render with, including the
+//                              calling thread (0 to decide automatically).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::render(const Quest *quest, const Snapshot &frame, int width,
+                       int height, int nThreads) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  if (width != width_ || height != height_) {
+    width_ = width;
+    height_ = height;
+    stride_ = (width + RAYCAST_LANES - 1) / RAYCAST_LANES * RAYCAST_LANES;
+    pixels_.assign(stride_ * height, OPAQUE_ALPHA);
+    depths_.resize(stride_);
+    wallBottoms_.resize(stride_);
+    wallTops_.resize(stride_);
+  }
+  quest_ = quest;
+  for (int m = 0; m < NUM_MATERIALS; ++m) {
+    static const unsigned char GRAY[3] = {128, 128, 128};
+    const gliGenericImage *image =
+      getTextureImage(quest->getMaterialIndex(m));
+    RaycastTexture &texture = textures_[m];
+
+    if (image && image->pixels && image->width > 0 && image->height > 0 &&
+        image->components > 0) {
+      bool isBgr = image->format == GL_BGR || image->format == GL_BGRA;
+      texture.pixels = image->pixels;
+      texture.width = image->width;
+      texture.height = image->height;
+      texture.components = image->components;
+      texture.red = image->components < 3 ? 0 : (isBgr ? 2 : 0);
+      texture.green = image->components < 3 ? 0 : 1;
+      texture.blue = image->components < 3 ? 0 : (isBgr ? 0 : 2);
+    } else {  // a missing texture is drawn gray
+      texture.pixels = GRAY;
+      texture.width = 1;
+      texture.height = 1;
+      texture.components = 3;
+      texture.red = 0;
+      texture.green = 1;
+      texture.blue = 2;
+    }
+  }
+
+  // the eye and view direction, as set by 'renderFrame'
+  const CrowdInstance &player = frame.player;
+  double angle = player.rotation * PI / 180.0;
+  eyeX_ = player.x;
+  eyeY_ = player.y;
+  eyeZ_ = player.z + player.height / 1.5;
+  forwardX_ = (float) cos(angle);
+  forwardY_ = (float) sin(angle);
+  focalLength_ = (float) (height / 2.0 /
+                          tan(RAYCAST_FIELD_OF_VIEW * PI / 360.0));
+
+  // characters, projected onto the screen
+  sprites_.clear();
+  for (size_t i = 0; i < frame.characters.size(); ++i) {
+    const CrowdInstance &character = frame.characters[i];
+    float dx = character.x - eyeX_,
+          dy = character.y - eyeY_;
+    RaycastSprite sprite;
+
+    sprite.depth = dx * forwardX_ + dy * forwardY_;
+    if (sprite.depth < 0.1f) {  // behind the near plane
+      continue;
+    }
+    float scale = focalLength_ / sprite.depth;
+    sprite.centerX = (dx * forwardY_ - dy * forwardX_) * scale;
+    sprite.halfWidth = character.radius * scale;
+    sprite.bottom = (character.z - eyeZ_) * scale;
+    sprite.top = (character.z + character.height - eyeZ_) * scale;
+    sprite.color = (uint32_t) (character.red * 255.0f + 0.5f) |
+                   ((uint32_t) (character.green * 255.0f + 0.5f) << 8) |
+                   ((uint32_t) (character.blue * 255.0f + 0.5f) << 16) |
+                   OPAQUE_ALPHA;
+    sprites_.push_back(sprite);
+  }
+  sort(sprites_.begin(), sprites_.end(), compareSprites);
+
+  int nStrips = (stride_ + RAYCAST_STRIP_WIDTH - 1) / RAYCAST_STRIP_WIDTH;
+  if (nThreads <= 0) {
+    nThreads = max(1, (int) thread::hardware_concurrency());
+  }
+  nThreads = min(nThreads, nStrips);
+
+  while ((int) workers_.size() < nThreads - 1) {
+    workers_.push_back(thread(&Raycaster::runWorker, this,
+                              (int) workers_.size()));
+  }
+  nextStrip_ = 0;
+  {
+    lock_guard<mutex> lock(mutex_);
+    nHelpers_ = nThreads - 1;
+    nBusyHelpers_ = nHelpers_;
+    ++frameNo_;
+  }
+  isFrameReady_.notify_all();
+  renderStrips(&nextStrip_);
+
+  unique_lock<mutex> lock(mutex_);
+  while (nBusyHelpers_ > 0) {
+    isFrameDone_.wait(lock);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getPixels
+//
+// Description: Returns the latest frame's pixels: 'getHeight' rows of
+//              'getStride' RGBA pixels each (of which the first 'getWidth'
+//              are on screen), bottom row first.
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the first pixel, or NULL before the first frame.
+//------------------------------------------------------------------------------
+const uint32_t *Raycaster::getPixels() const {
+  return pixels_.empty() ? NULL : &pixels_[0];
+}
+
+//------------------------------------------------------------------------------
+//      Method: getWidth
+//
+// Description: Returns the width of the latest frame.
+//
+//      Inputs: None.
+//
+//     Outputs: The frame's width, in pixels.
+//------------------------------------------------------------------------------
+int Raycaster::getWidth() const {
+  return width_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getHeight
+//
+// Description: Returns the height of the latest frame.
+//
+//      Inputs: None.
+//
+//     Outputs: The frame's height, in pixels.
+//------------------------------------------------------------------------------
+int Raycaster::getHeight() const {
+  return height_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getStride
+//
+// Description: Returns the number of pixels from the start of one row of the
+//              latest frame to the start of the next (for
+//              GL_UNPACK_ROW_LENGTH).
+//
+//      Inputs: None.
+//
+//     Outputs: The frame's row length, in pixels.
+//------------------------------------------------------------------------------
+int Raycaster::getStride() const {
+  return stride_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: save
+//
+// Description: Saves the latest frame as a binary PPM image.
+//
+//      Inputs: filename - Path of the image file.
+//
+//     Outputs: 0 if successful, 1 if the file could not be written.
+//------------------------------------------------------------------------------
+int Raycaster::save(const char *filename) const {
+  FILE *file = fopen(filename, "wb");
+
+  if (!file) {
+    cerr << "Error: unable to open \"" << filename << "\" for writing."
+         << endl;
+    return 1;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", width_, height_);
+
+  vector<unsigned char> row(width_ * 3);
+  for (int y = height_ - 1; y >= 0; --y) {  // PPM rows run top to bottom
+    const uint32_t *pixel = &pixels_[y * stride_];
+    for (int x = 0; x < width_; ++x) {
+      row[x * 3] = pixel[x] & 0xff;
+      row[x * 3 + 1] = (pixel[x] >> 8) & 0xff;
+      row[x * 3 + 2] = (pixel[x] >> 16) & 0xff;
+    }
+    fwrite(&row[0], 1, row.size(), file);
+  }
+
+  bool isWritten = !ferror(file);
+  if (fclose(file) != 0 || !isWritten) {
+    cerr << "Error: unable to write \"" << filename << "\"." << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: runWorker
+//
+// Description: A private method run by each worker thread until the Raycaster
+//              is destroyed: waits for each new frame and, if among the
+//              threads asked to help with it, renders strips of it alongside
+//              the calling thread (see 'render').
+//
+//      Inputs: index - The worker's index (from 0) among the workers.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::runWorker(int index) {
+  unique_lock<mutex> lock(mutex_);
+  int frameNo = 0;
+
+  while (true) {
+    while (frameNo_ == frameNo && !isStopping_) {
+      isFrameReady_.wait(lock);
+    }
+    if (isStopping_) {
+      return;
+    }
+    frameNo = frameNo_;
+    if (index >= nHelpers_) {
+      continue;
+    }
+    lock.unlock();
+    renderStrips(&nextStrip_);
+    lock.lock();
+    if (--nBusyHelpers_ == 0) {
+      isFrameDone_.notify_one();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: renderStrips
+//
+// Description: A private method run by each rendering thread: takes strips of
+//              RAYCAST_STRIP_WIDTH columns in turn until none remain, casting
+//              a ray per column, then filling in the floor, ceiling, and
+//              characters. Strips share no pixels, so no locking is needed.
+//
+//      Inputs: nextStrip - Index of the next strip to be taken.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::renderStrips(atomic<int> *nextStrip) {
+  int nStrips = (stride_ + RAYCAST_STRIP_WIDTH - 1) / RAYCAST_STRIP_WIDTH,
+      strip;
+
+  while ((strip = nextStrip->fetch_add(1)) < nStrips) {
+    int firstColumn = strip * RAYCAST_STRIP_WIDTH,
+        lastColumn = min(firstColumn + RAYCAST_STRIP_WIDTH, stride_);
+
+    for (int column = firstColumn; column < lastColumn; ++column) {
+      castColumn(column);
+    }
+    drawFloorAndCeiling(firstColumn, lastColumn);
+    drawSprites(firstColumn, lastColumn);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: castColumn
+//
+// Description: A private method that steps a column's ray from cell to cell
+//              until it meets a wall (cells beyond the maze count as walls),
+//              then draws the wall's span of the column, recording its rows
+//              and distance.
+//
+//      Inputs: column - The column of interest.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::castColumn(int column) {
+  // the ray advances one unit along the view direction per unit of 't'
+  float offset = (column + 0.5f - width_ * 0.5f) / focalLength_,
+        rayX = forwardX_ + forwardY_ * offset,
+        rayY = forwardY_ - forwardX_ * offset,
+        deltaX = rayX != 0.0f ? fabs(1.0f / rayX) : 1e30f,
+        deltaY = rayY != 0.0f ? fabs(1.0f / rayY) : 1e30f;
+  int x = (int) floor(eyeX_),
+      y = (int) floor(eyeY_),
+      stepX = rayX < 0.0f ? -1 : 1,
+      stepY = rayY < 0.0f ? -1 : 1,
+      side;
+  float nextX = (rayX < 0.0f ? eyeX_ - x : x + 1.0f - eyeX_) * deltaX,
+        nextY = (rayY < 0.0f ? eyeY_ - y : y + 1.0f - eyeY_) * deltaY,
+        distance;
+
+  while (true) {
+    if (nextX < nextY) {
+      side = stepX > 0 ? EAST : WEST;
+      distance = nextX;
+      if (quest_->hasWallAt(x, y, side)) {
+        break;
+      }
+      x += stepX;
+      nextX += deltaX;
+    } else {
+      side = stepY > 0 ? NORTH : SOUTH;
+      distance = nextY;
+      if (quest_->hasWallAt(x, y, side)) {
+        break;
+      }
+      y += stepY;
+      nextY += deltaY;
+    }
+  }
+  distance = max(distance, 1e-4f);
+  depths_[column] = distance;
+
+  // the start and finish doors (see 'MazeMesh::build')
+  int material = WALL_MATERIAL;
+  if ((side == NORTH && x == quest_->getFinishX() &&
+       y == quest_->getHeight() - 1) ||
+      (side == SOUTH && x == quest_->getStartX() && y == 0)) {
+    material = DOOR_MATERIAL;
+  }
+  const RaycastTexture &texture = textures_[material];
+
+  // the texture runs along x (or y) and up the wall, once per cell
+  float along = (side == EAST || side == WEST) ? eyeY_ + rayY * distance :
+                                                 eyeX_ + rayX * distance;
+  int textureX = min((int) ((along - floor(along)) * texture.width),
+                     texture.width - 1);
+
+  // rows whose centers lie between the wall's bottom (z = 0) and top (z = 1)
+  float scale = focalLength_ / distance,
+        center = height_ * 0.5f - 0.5f;
+  int bottom = (int) ceil(center - eyeZ_ * scale),
+      top = (int) ceil(center + (1.0f - eyeZ_) * scale);
+  bottom = max(0, min(height_, bottom));
+  top = max(bottom, min(height_, top));
+  wallBottoms_[column] = bottom;
+  wallTops_[column] = top;
+
+  float z = eyeZ_ + (bottom - center) / scale,
+        dz = 1.0f / scale;
+  uint32_t *pixel = &pixels_[bottom * stride_ + column];
+  for (int row = bottom; row < top; ++row) {
+    int textureY = max(0, min(texture.height - 1,
+                              (int) (z * texture.height)));
+    *pixel = getTexel(texture, (textureY * texture.width + textureX) *
+                               texture.components);
+    pixel += stride_;
+    z += dz;
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawFloorAndCeiling
+//
+// Description: A private method that fills in the floor below, and the ceiling
+//              above, the walls of a range of columns, a row at a time: every
+//              column of a row sees the floor (or ceiling) at the same
+//              distance, so the texels seen by RAYCAST_LANES columns are found
+//              at once (see 'getTexelOffsets').
+//
+//      Inputs: firstColumn - The first column of the range.
+//              lastColumn  - The column just past the range (the range's width
+//                            must be a multiple of RAYCAST_LANES).
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::drawFloorAndCeiling(int firstColumn, int lastColumn) {
+  alignas(32) int offsets[RAYCAST_LANES];
+  alignas(32) uint32_t texels[RAYCAST_LANES];
+  int floorTop = 0,
+      ceilingBottom = height_;
+  float center = height_ * 0.5f - 0.5f,
+        firstOffset = (firstColumn + 0.5f - width_ * 0.5f) / focalLength_;
+
+  for (int column = firstColumn; column < lastColumn; ++column) {
+    floorTop = max(floorTop, wallBottoms_[column]);
+    ceilingBottom = min(ceilingBottom, wallTops_[column]);
+  }
+  for (int pass = 0; pass < 2; ++pass) {
+    bool isFloor = pass == 0;
+    const RaycastTexture &texture =
+      textures_[isFloor ? FLOOR_MATERIAL : CEILING_MATERIAL];
+    const int *limits = isFloor ? &wallBottoms_[0] : &wallTops_[0];
+    int firstRow = isFloor ? 0 : ceilingBottom,
+        lastRow = isFloor ? floorTop : height_;
+
+    for (int row = firstRow; row < lastRow; ++row) {
+      // distance to where this row meets the floor (z = 0) or ceiling (z = 1)
+      float height = isFloor ? center - row : row - center;
+      if (height <= 0.0f) {  // at or beyond the horizon
+        continue;
+      }
+      float distance = (isFloor ? eyeZ_ : 1.0f - eyeZ_) * focalLength_ /
+                       height,
+            x = eyeX_ + distance * (forwardX_ + forwardY_ * firstOffset),
+            y = eyeY_ + distance * (forwardY_ - forwardX_ * firstOffset),
+            stepX = distance * forwardY_ / focalLength_,
+            stepY = -distance * forwardX_ / focalLength_;
+      uint32_t *pixels = &pixels_[row * stride_];
+
+      for (int column = firstColumn; column < lastColumn;
+           column += RAYCAST_LANES) {
+        IntLanes mask = getRowMask(limits + column, row, isFloor);
+        if (isAnyLaneSet(mask)) {
+          int k = column - firstColumn;
+          getTexelOffsets(x + stepX * k, y + stepY * k, stepX, stepY, texture,
+                          offsets);
+          for (int lane = 0; lane < RAYCAST_LANES; ++lane) {
+            texels[lane] = getTexel(texture, offsets[lane]);
+          }
+          blendLanes(pixels + column, texels, mask);
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: drawSprites
+//
+// Description: A private method that draws, from far to near, the characters
+//              seen within a range of columns, in columns where no wall is
+//              nearer.
+//
+//      Inputs: firstColumn - The first column of the range.
+//              lastColumn  - The column just past the range.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Raycaster::drawSprites(int firstColumn, int lastColumn) {
+  float centerX = width_ * 0.5f - 0.5f,
+        centerY = height_ * 0.5f - 0.5f;
+
+  lastColumn = min(lastColumn, width_);
+  for (size_t i = 0; i < sprites_.size(); ++i) {
+    const RaycastSprite &sprite = sprites_[i];
+    int left = (int) ceil(centerX + sprite.centerX - sprite.halfWidth),
+        right = (int) ceil(centerX + sprite.centerX + sprite.halfWidth),
+        bottom = (int) ceil(centerY + sprite.bottom),
+        top = (int) ceil(centerY + sprite.top);
+
+    left = max(left, firstColumn);
+    right = min(right, lastColumn);
+    bottom = max(bottom, 0);
+    top = min(top, height_);
+    for (int column = left; column < right; ++column) {
+      if (sprite.depth >= depths_[column]) {
+        continue;
+      }
+      uint32_t *pixel = &pixels_[bottom * stride_ + column];
+      for (int row = bottom; row < top; ++row) {
+        *pixel = sprite.color;
+        pixel += stride_;
+      }
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/*******************************************************************************
+   Filename: raycaster.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Raycaster' class, a software renderer for the
+             first-person view of a finite maze that needs no OpenGL at all.
+             Since every wall lies on the cell grid, one ray per screen column,
+             stepped from cell to cell (grid DDA), finds the nearest wall; its
+             column of texels is then read straight from the loaded texture
+             images. The floor and ceiling are drawn a row at a time across
+             several columns at once with SSE2 (or AVX2, if the compiler
+             targets it), and characters are drawn as flat, camera-facing
+             rectangles, hidden wherever a wall is nearer. The screen is split
+             into strips of RAYCAST_STRIP_WIDTH columns, which worker threads
+             take in turn; the workers are started with the first frame and
+             wait between frames, so no threads are created per frame. Frames
+             are stored as RGBA rows, bottom row first, ready for
+             'glDrawPixels' or for saving as a PPM image, so the renderer
+             serves both as a fast path on machines where software OpenGL is
+             too slow and as a reference renderer for headless tests.
+*******************************************************************************/
+
+#ifndef RAYCASTER_H_
+#define RAYCASTER_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "main.h"
+
+using namespace std;
+
+class Quest;
+struct CrowdInstance;
+struct Snapshot;
+
+const double RAYCAST_FIELD_OF_VIEW = 35.0;  // vertical, in degrees, as in GL
+const int RAYCAST_STRIP_WIDTH = 32;  // columns per unit of work
+
+// A character as it appears on screen. Columns and rows are measured from the
+// left and bottom edges, with the center of the screen at (0, 0).
+struct RaycastSprite {
+  float depth,  // distance along the view direction
+        centerX,
+        halfWidth,
+        bottom,
+        top;
+  uint32_t color;
+};
+
+// A texture image's pixels, as read by the raycaster.
+struct RaycastTexture {
+  const unsigned char *pixels;
+  int width,
+      height,
+      components,  // bytes per pixel
+      red,  // byte offsets of the color components within a pixel
+      green,
+      blue;
+};
+
+class Raycaster {
+ public:
+  Raycaster();
+  ~Raycaster();
+  void render(const Quest *quest, const Snapshot &frame, int width, int height,
+              int nThreads = 0);
+  const uint32_t *getPixels() const;
+  int getWidth() const;
+  int getHeight() const;
+  int getStride() const;
+  int save(const char *filename) const;
+ private:
+  int width_,
+      height_,
+      stride_;  // pixels per row, a multiple of the SIMD width
+  vector<uint32_t> pixels_;
+  vector<float> depths_;  // per column, distance along the view direction
+  vector<int> wallBottoms_,  // per column, first row of the wall
+              wallTops_;  // per column, first row above the wall
+  vector<RaycastSprite> sprites_;  // sorted far to near
+  const Quest *quest_;
+  RaycastTexture textures_[NUM_MATERIALS];
+  float eyeX_,
+        eyeY_,
+        eyeZ_,
+        forwardX_,
+        forwardY_,
+        focalLength_;  // in pixels
+
+  // shared with the worker threads
+  vector<thread> workers_;
+  mutex mutex_;
+  condition_variable isFrameReady_,
+                     isFrameDone_;
+  atomic<int> nextStrip_;
+  int frameNo_,  // number of frames handed to the workers
+      nHelpers_,  // workers taking part in the current frame
+      nBusyHelpers_;  // of those, the ones not yet finished
+  bool isStopping_;
+
+  void runWorker(int index);
+  void renderStrips(atomic<int> *nextStrip);
+  void castColumn(int column);
+  void drawFloorAndCeiling(int firstColumn, int lastColumn);
+  void drawSprites(int firstColumn, int lastColumn);
+};
+
+#endif  // RAYCASTER_H_
@@ -0,0 +1,361 @@
+/*******************************************************************************
+   Filename: recorder.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'FrameRecorder' class, which records gameplay as
+             a Y4M video through asynchronous pixel buffer readback.
+*******************************************************************************/
+
+#include "recorder.h"
+
+//------------------------------------------------------------------------------
+//      Method: FrameRecorder
+//
+// Description: Constructs a FrameRecorder that is not yet recording.
+//
+//      Inputs: frameRate - The video's frame rate, in frames per second.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+FrameRecorder::FrameRecorder(double frameRate) {
+  frameRate_ = frameRate > 0.0 ? frameRate : DEFAULT_RECORDING_RATE;
+  file_ = NULL;
+  filename_ = NULL;
+  isRecording_ = false;
+  nFramesDue_ = 0;
+  for (int i = 0; i < RECORDER_NUM_BUFFERS; ++i) {
+    buffers_[i] = 0;
+    bufferSizes_[i] = 0;
+    widths_[i] = 0;
+    heights_[i] = 0;
+    nCopies_[i] = 0;
+  }
+  nextBuffer_ = 0;
+  isStopping_ = false;
+  nFramesWritten_ = 0;
+  nFramesDropped_ = 0;
+  videoWidth_ = 0;
+  videoHeight_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~FrameRecorder
+//
+// Description: Destructs the FrameRecorder, finishing any recording first
+//              (see 'stop').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+FrameRecorder::~FrameRecorder() {
+  stop();
+  for (size_t i = 0; i < freeFrames_.size(); ++i) {
+    delete freeFrames_[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: start
+//
+// Description: Opens the video file and starts the encoder thread. The video's
+//              size is that of the first frame captured.
+//
+//      Inputs: filename - Path of the video file (conventionally ".y4m").
+//
+//     Outputs: Returns 'true' if recording has started, 'false' if the file
+//              could not be opened.
+//------------------------------------------------------------------------------
+bool FrameRecorder::start(const char *filename) {
+  if (isRecording_) {
+    return true;
+  }
+  file_ = fopen(filename, "wb");
+  if (!file_) {
+    cerr << "Error: unable to open \"" << filename << "\" for writing."
+         << endl;
+    return false;
+  }
+  filename_ = filename;
+  isRecording_ = true;
+  isStopping_ = false;
+  nFramesDue_ = 0;
+  nFramesWritten_ = 0;
+  nFramesDropped_ = 0;
+  videoWidth_ = 0;
+  videoHeight_ = 0;
+  encoder_ = thread(&FrameRecorder::encode, this);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: capture
+//
+// Description: Captures the frame just drawn into the framebuffer bound for
+//              reading (the window's back buffer, before it is swapped, or an
+//              offscreen framebuffer), if a video frame has come due since the
+//              last capture. The frame is read into the next buffer of the
+//              ring, after the frame that buffer last received is passed on to
+//              the encoder. Never waits for the frame just requested.
+//
+//      Inputs: width, height - The frame's size, in pixels.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void FrameRecorder::capture(int width, int height) {
+  if (!isRecording_ || width <= 0 || height <= 0) {
+    return;
+  }
+
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  if (nFramesDue_ == 0) {
+    startTime_ = now;
+  }
+
+  long nFramesDue = (long) (chrono::duration<double>(now - startTime_).count() *
+                            frameRate_) + 1;
+  if (nFramesDue <= nFramesDue_) {
+    return;  // the previous capture still stands for this moment
+  }
+
+  int buffer = nextBuffer_,
+      size = width * height * 4;
+  if (!buffers_[0]) {
+    glGenBuffers(RECORDER_NUM_BUFFERS, buffers_);
+  }
+  if (nCopies_[buffer] > 0) {
+    retire(buffer);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[buffer]);
+  if (size != bufferSizes_[buffer]) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    bufferSizes_[buffer] = size;
+  }
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glPopClientAttrib();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  widths_[buffer] = width;
+  heights_[buffer] = height;
+  nCopies_[buffer] = (int) (nFramesDue - nFramesDue_);
+  nFramesDue_ = nFramesDue;
+  nextBuffer_ = (buffer + 1) % RECORDER_NUM_BUFFERS;
+}
+
+//------------------------------------------------------------------------------
+//      Method: stop
+//
+// Description: Passes every frame still in the ring to the encoder, waits for
+//              it to write them all, closes the video file, and reports how
+//              many frames were recorded. Must be called with the OpenGL
+//              context of the captures current.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void FrameRecorder::stop() {
+  if (!isRecording_) {
+    return;
+  }
+  for (int i = 0; i < RECORDER_NUM_BUFFERS; ++i) {  // oldest first
+    int buffer = (nextBuffer_ + i) % RECORDER_NUM_BUFFERS;
+    if (nCopies_[buffer] > 0) {
+      retire(buffer);
+    }
+  }
+  if (buffers_[0]) {
+    glDeleteBuffers(RECORDER_NUM_BUFFERS, buffers_);
+  }
+  for (int i = 0; i < RECORDER_NUM_BUFFERS; ++i) {
+    buffers_[i] = 0;
+    bufferSizes_[i] = 0;
+  }
+  {
+    lock_guard<mutex> lock(mutex_);
+    isStopping_ = true;
+  }
+  isQueueReady_.notify_one();
+  encoder_.join();
+  isRecording_ = false;
+
+  bool isWritten = !ferror(file_);
+  if (fclose(file_) != 0 || !isWritten) {
+    cerr << "Error: unable to write \"" << filename_ << "\"." << endl;
+  } else {
+    cout << "Recorded " << nFramesWritten_ << " frames (" << videoWidth_
+         << "x" << videoHeight_ << " at " << frameRate_ << " frames/s) to "
+         << filename_;
+    if (nFramesDropped_ > 0) {
+      cout << ", dropping " << nFramesDropped_ << " the encoder could not "
+           << "keep up with";
+    }
+    cout << endl;
+  }
+  file_ = NULL;
+}
+
+//------------------------------------------------------------------------------
+//      Method: retire
+//
+// Description: A private method that copies the frame pending in a given
+//              buffer of the ring into a free frame and queues it for the
+//              encoder, unless the encoder is too far behind, in which case
+//              the frame is dropped.
+//
+//      Inputs: buffer - Index of the buffer within the ring.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void FrameRecorder::retire(int buffer) {
+  RecordedFrame *frame = NULL;
+  int nCopies = nCopies_[buffer];
+
+  nCopies_[buffer] = 0;
+  {
+    lock_guard<mutex> lock(mutex_);
+    if ((int) queue_.size() >= RECORDER_MAX_QUEUED) {
+      nFramesDropped_ += nCopies;
+      return;
+    }
+    if (!freeFrames_.empty()) {
+      frame = freeFrames_.back();
+      freeFrames_.pop_back();
+    }
+  }
+  if (!frame) {
+    frame = new RecordedFrame();
+  }
+  frame->width = widths_[buffer];
+  frame->height = heights_[buffer];
+  frame->nCopies = nCopies;
+  frame->pixels.resize(frame->width * frame->height * 4);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[buffer]);
+  const void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pixels) {
+    memcpy(&frame->pixels[0], pixels, frame->pixels.size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    fill(frame->pixels.begin(), frame->pixels.end(), 0);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  {
+    lock_guard<mutex> lock(mutex_);
+    queue_.push_back(frame);
+  }
+  isQueueReady_.notify_one();
+}
+
+//------------------------------------------------------------------------------
+//      Method: encode
+//
+// Description: A private method run by the encoder thread: writes queued
+//              frames, oldest first, until stopped and the queue is empty.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void FrameRecorder::encode() {
+  unique_lock<mutex> lock(mutex_);
+
+  while (true) {
+    while (queue_.empty() && !isStopping_) {
+      isQueueReady_.wait(lock);
+    }
+    if (queue_.empty()) {
+      return;
+    }
+
+    RecordedFrame *frame = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    write(*frame);
+    lock.lock();
+    nFramesWritten_ += frame->nCopies;
+    freeFrames_.push_back(frame);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: write
+//
+// Description: A private method that converts a frame to YUV 4:2:0 (BT.601,
+//              studio range) and appends it to the video as many times as it
+//              is due. The first frame also determines the video's size and
+//              writes the header; later frames of another size (e.g., after
+//              the window is resized) are cropped or padded with black.
+//
+//      Inputs: frame - The frame to be written.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void FrameRecorder::write(const RecordedFrame &frame) {
+  if (videoWidth_ == 0) {
+    videoWidth_ = max(2, frame.width & ~1);
+    videoHeight_ = max(2, frame.height & ~1);
+    fprintf(file_, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n",
+            videoWidth_, videoHeight_, (int) (frameRate_ * 1000.0 + 0.5));
+    planes_.resize(videoWidth_ * videoHeight_ * 3 / 2);
+  }
+
+  int chromaWidth = videoWidth_ / 2,
+      width = min(videoWidth_, frame.width & ~1);  // columns to convert
+  unsigned char *yPlane = &planes_[0],
+                *uPlane = yPlane + videoWidth_ * videoHeight_,
+                *vPlane = uPlane + chromaWidth * (videoHeight_ / 2);
+
+  // black everywhere the frame does not reach
+  if (width < videoWidth_ || frame.height < videoHeight_) {
+    fill(yPlane, uPlane, 16);
+    fill(uPlane, yPlane + planes_.size(), 128);
+  }
+
+  // two rows at a time, top first (the frame's rows run bottom to top)
+  for (int y = 0; y + 1 < min(videoHeight_, frame.height); y += 2) {
+    const unsigned char *top = &frame.pixels[(frame.height - 1 - y) *
+                                             frame.width * 4],
+                        *bottom = top - frame.width * 4;
+    unsigned char *yTop = yPlane + y * videoWidth_,
+                  *yBottom = yTop + videoWidth_,
+                  *u = uPlane + (y / 2) * chromaWidth,
+                  *v = vPlane + (y / 2) * chromaWidth;
+
+    for (int x = 0; x < width; x += 2) {
+      const unsigned char *pixels[4] = {top, top + 4, bottom, bottom + 4};
+      unsigned char *luma[4] = {yTop + x, yTop + x + 1, yBottom + x,
+                                yBottom + x + 1};
+      int red = 0,
+          green = 0,
+          blue = 0;
+      for (int k = 0; k < 4; ++k) {
+        int r = pixels[k][0],
+            g = pixels[k][1],
+            b = pixels[k][2];
+        *luma[k] = (unsigned char) (((66 * r + 129 * g + 25 * b + 128) >> 8) +
+                                    16);
+        red += r;
+        green += g;
+        blue += b;
+      }
+      red = (red + 2) >> 2;
+      green = (green + 2) >> 2;
+      blue = (blue + 2) >> 2;
+      u[x / 2] = (unsigned char)
+        (((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+      v[x / 2] = (unsigned char)
+        (((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+      top += 8;
+      bottom += 8;
+    }
+  }
+  for (int i = 0; i < frame.nCopies; ++i) {
+    fputs("FRAME\n", file_);
+    fwrite(&planes_[0], 1, planes_.size(), file_);
+  }
+}
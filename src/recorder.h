@@ -0,0 +1,90 @@
+/*******************************************************************************
+   Filename: recorder.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'FrameRecorder' class, which records gameplay as
+             a Y4M video (uncompressed YUV 4:2:0, readable by most video
+             tools) without stalling the rendering thread. Each captured
+             frame is read back into one of a ring of RECORDER_NUM_BUFFERS
+             pixel buffer objects, which returns at once; the frame is only
+             copied out of its buffer when the ring comes back around to it,
+             by which time the copy no longer waits for the GPU. The copy is
+             then handed to a background thread that converts it to YUV and
+             writes it. Frames are captured at a fixed rate, independent of
+             the frame rate: a frame is skipped if none is due, and repeated
+             if several are. If the encoder falls more than
+             RECORDER_MAX_QUEUED frames behind, frames are dropped (and
+             counted) rather than letting the game slow down.
+*******************************************************************************/
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <cstdio>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "main.h"
+
+using namespace std;
+
+const double DEFAULT_RECORDING_RATE = 30.0;  // frames per second
+const int RECORDER_NUM_BUFFERS = 3;
+const int RECORDER_MAX_QUEUED = 8;  // frames awaiting the encoder
+
+// A frame read back from OpenGL: RGBA rows, bottom row first.
+struct RecordedFrame {
+  int width,
+      height,
+      nCopies;  // times the frame appears in the video
+  vector<unsigned char> pixels;
+};
+
+class FrameRecorder {
+ public:
+  FrameRecorder(double frameRate = DEFAULT_RECORDING_RATE);
+  ~FrameRecorder();
+  bool start(const char *filename);
+  void capture(int width, int height);
+  void stop();
+ private:
+  double frameRate_;
+  FILE *file_;
+  const char *filename_;
+  bool isRecording_;
+  chrono::steady_clock::time_point startTime_;
+  long nFramesDue_;
+
+  // render thread only
+  GLuint buffers_[RECORDER_NUM_BUFFERS];
+  int bufferSizes_[RECORDER_NUM_BUFFERS],  // in bytes, as allocated
+      widths_[RECORDER_NUM_BUFFERS],  // of the pending frames
+      heights_[RECORDER_NUM_BUFFERS],
+      nCopies_[RECORDER_NUM_BUFFERS],  // 0 if no frame is pending
+      nextBuffer_;
+
+  // shared with the encoder thread
+  mutex mutex_;
+  condition_variable isQueueReady_;
+  deque<RecordedFrame *> queue_;
+  vector<RecordedFrame *> freeFrames_;
+  bool isStopping_;
+  long nFramesWritten_,
+       nFramesDropped_;
+  thread encoder_;
+
+  // encoder thread only
+  int videoWidth_,  // of the first frame, rounded down to even
+      videoHeight_;
+  vector<unsigned char> planes_;  // Y, then U, then V
+
+  void retire(int buffer);
+  void encode();
+  void write(const RecordedFrame &frame);
+};
+
+#endif  // RECORDER_H_
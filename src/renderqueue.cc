@@ -0,0 +1,265 @@
+/*******************************************************************************
+   Filename: renderqueue.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'RenderQueue' class, which submits a frame's
+             meshes grouped by material (or whole, given a texture array) and
+             ordered front to back.
+*******************************************************************************/
+
+#include <algorithm>
+#include "renderqueue.h"
+
+//------------------------------------------------------------------------------
+//      Method: compareRenderItems
+//
+// Description: A static helper that orders render items by material, then by
+//              distance from the viewer (nearest first).
+//
+//      Inputs: a, b - The render items to be compared.
+//
+//     Outputs: Returns 'true' if 'a' is to be drawn before 'b'.
+//------------------------------------------------------------------------------
+static bool compareRenderItems(const RenderItem &a, const RenderItem &b) {
+  if (a.material != b.material) {
+    return a.material < b.material;
+  }
+
+  return a.distance < b.distance;
+}
+
+//------------------------------------------------------------------------------
+//      Method: RenderQueue
+//
+// Description: Constructs an empty RenderQueue.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+RenderQueue::RenderQueue() {
+  textureArray_ = 0;
+  nLayers_ = 0;
+  lightmap_ = 0;
+  nStateChanges_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: setTextureArray
+//
+// Description: Sets the texture array through which meshes added from now on
+//              are drawn (see 'getTextureArray').
+//
+//      Inputs: textureArray - The 3D texture holding one texture per layer, or
+//                             0 to draw with a separate texture per material.
+//              nLayers      - Number of layers in the texture array.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void RenderQueue::setTextureArray(int textureArray, int nLayers) {
+  textureArray_ = textureArray;
+  nLayers_ = nLayers;
+}
+
+//------------------------------------------------------------------------------
+//      Method: setLightmap
+//
+// Description: Sets the lightmap (see 'MazeLighting::getLightmap') that
+//              modulates the textures of meshes submitted from now on.
+//
+//      Inputs: lightmap - The lightmap texture, or 0 to draw unlit.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void RenderQueue::setLightmap(int lightmap) {
+  lightmap_ = lightmap;
+}
+
+//------------------------------------------------------------------------------
+//      Method: clear
+//
+// Description: Empties the queue in preparation for a new frame (the memory
+//              it holds is kept for reuse).
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void RenderQueue::clear() {
+  items_.clear();
+}
+
+//------------------------------------------------------------------------------
+//      Method: add
+//
+// Description: Queues a given mesh: as a whole if a texture array is set,
+//              otherwise as one item per non-empty material group.
+//
+//      Inputs: mesh             - The mesh to be drawn.
+//              viewerX, viewerY - The viewer's location, used to order meshes
+//                                 front to back.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void RenderQueue::add(MazeMesh *mesh, double viewerX, double viewerY) {
+  double dx = mesh->getCenterX() - viewerX,
+         dy = mesh->getCenterY() - viewerY;
+  RenderItem item = {ALL_MATERIALS, (float) (dx * dx + dy * dy), mesh};
+
+  if (textureArray_ > 0) {
+    items_.push_back(item);
+    return;
+  }
+  for (item.material = 0; item.material < NUM_MATERIALS; ++item.material) {
+    if (mesh->getNumVertices(item.material) > 0) {
+      items_.push_back(item);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: submit
+//
+// Description: Draws every queued item, grouped by material and nearest first
+//              within each group. Texturing is enabled and each material's
+//              texture bound once per group, so a frame costs at most a few
+//              texture state changes however many meshes are queued. Whole
+//              meshes come first: the texture array is bound once, and the
+//              texture matrix maps each vertex's layer number to the center
+//              of that layer. If a lightmap is set, texture unit 1 modulates
+//              each texture by it. Two-sided meshes (see
+//              'MazeMesh::isTwoSided') are drawn with back-face culling on,
+//              so that only the side of a wall facing the viewer is drawn.
+//              Ceilings are drawn only in first-person perspective. The queue
+//              is left intact (see 'clear').
+//
+//      Inputs: perspective - Integer representing the current perspective.
+//              textures    - Array of NUM_MATERIALS texture numbers (0 for an
+//                            untextured material).
+//
+//     Outputs: The number of texture state changes made (see
+//              'getNumStateChanges').
+//------------------------------------------------------------------------------
+int RenderQueue::submit(int perspective, const int *textures) {
+  bool isTextured = false,
+       isCulling = false;
+  MazeMesh *boundMesh = NULL;
+
+  sort(items_.begin(), items_.end(), compareRenderItems);
+  nStateChanges_ = 0;
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  if (lightmap_ > 0) {
+    glActiveTexture(GL_TEXTURE1);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, lightmap_);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glActiveTexture(GL_TEXTURE0);
+    glClientActiveTexture(GL_TEXTURE1);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glClientActiveTexture(GL_TEXTURE0);
+    nStateChanges_ += 2;
+  }
+  for (int i = 0; i < items_.size(); ++i) {
+    const RenderItem &item = items_[i];
+    if (item.mesh->isTwoSided() != isCulling) {
+      isCulling = !isCulling;
+      if (isCulling) {
+        glEnable(GL_CULL_FACE);
+      } else {
+        glDisable(GL_CULL_FACE);
+      }
+    }
+    if (item.material == ALL_MATERIALS) {
+      if (i == 0) {
+        glEnable(GL_TEXTURE_3D);
+        glBindTexture(GL_TEXTURE_3D, textureArray_);
+        glMatrixMode(GL_TEXTURE);
+        glLoadIdentity();
+        glScaled(1.0, 1.0, 1.0 / nLayers_);
+        glTranslated(0.0, 0.0, 0.5);
+        glMatrixMode(GL_MODELVIEW);
+        nStateChanges_ += 2;
+      }
+      item.mesh->bind(true);
+      item.mesh->drawAll(perspective);
+      if (i + 1 == items_.size() || items_[i + 1].material != ALL_MATERIALS) {
+        glMatrixMode(GL_TEXTURE);
+        glLoadIdentity();
+        glMatrixMode(GL_MODELVIEW);
+        glDisable(GL_TEXTURE_3D);
+      }
+      continue;
+    }
+    if (item.material == CEILING_MATERIAL && perspective != FIRST_PERSON) {
+      continue;
+    }
+    if (i == 0 || item.material != items_[i - 1].material) {
+      if (textures[item.material] > 0) {
+        if (!isTextured) {
+          glEnable(GL_TEXTURE_2D);
+          isTextured = true;
+          ++nStateChanges_;
+        }
+        glBindTexture(GL_TEXTURE_2D, textures[item.material]);
+        ++nStateChanges_;
+      } else if (isTextured) {
+        glDisable(GL_TEXTURE_2D);
+        isTextured = false;
+        ++nStateChanges_;
+      }
+    }
+    if (item.mesh != boundMesh) {
+      item.mesh->bind(false);
+      boundMesh = item.mesh;
+    }
+    item.mesh->drawMaterial(item.material);
+  }
+  if (isTextured) {
+    glDisable(GL_TEXTURE_2D);
+  }
+  if (isCulling) {
+    glDisable(GL_CULL_FACE);
+  }
+  if (lightmap_ > 0) {
+    glActiveTexture(GL_TEXTURE1);
+    glDisable(GL_TEXTURE_2D);
+    glActiveTexture(GL_TEXTURE0);
+    glClientActiveTexture(GL_TEXTURE1);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glClientActiveTexture(GL_TEXTURE0);
+  }
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  return nStateChanges_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumItems
+//
+// Description: Returns the number of items currently queued.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of queued items (one per mesh per material).
+//------------------------------------------------------------------------------
+int RenderQueue::getNumItems() const {
+  return items_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumStateChanges
+//
+// Description: Returns the number of texture state changes (enables, disables,
+//              and binds) made by the most recent 'submit'.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of texture state changes.
+//------------------------------------------------------------------------------
+int RenderQueue::getNumStateChanges() const {
+  return nStateChanges_;
+}
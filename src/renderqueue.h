@@ -0,0 +1,55 @@
+/*******************************************************************************
+   Filename: renderqueue.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'RenderQueue' class, which gathers the faces of
+             every visible mesh for a frame and submits them grouped by
+             material, so that each texture is bound only once per frame, and
+             ordered roughly front to back within each group, so that nearer
+             faces fill the depth buffer first and hidden fragments are
+             rejected early. When every texture is available as a layer of a
+             single texture array, each mesh is instead drawn whole with one
+             call and no texture rebinds at all. A lit maze's lightmap (see
+             'MazeLighting') modulates every texture from a second texture
+             unit.
+*******************************************************************************/
+
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class MazeMesh;
+
+const int ALL_MATERIALS = -1;
+
+// A mesh's faces of one material (or all of them), queued for drawing.
+struct RenderItem {
+  int material;
+  float distance;  // squared, from the viewer to the mesh's center
+  MazeMesh *mesh;
+};
+
+class RenderQueue {
+ public:
+  RenderQueue();
+  void setTextureArray(int textureArray, int nLayers);
+  void setLightmap(int lightmap);
+  void clear();
+  void add(MazeMesh *mesh, double viewerX, double viewerY);
+  int submit(int perspective, const int *textures);
+  int getNumItems() const;
+  int getNumStateChanges() const;
+ private:
+  vector<RenderItem> items_;
+  int textureArray_,
+      nLayers_,
+      lightmap_,
+      nStateChanges_;
+};
+
+#endif  // RENDERQUEUE_H_
@@ -0,0 +1,168 @@
+/*******************************************************************************
+   Filename: resolution.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'ResolutionScaler' class, which draws the 3D
+             scene at whatever resolution holds a target frame rate.
+*******************************************************************************/
+
+#include "resolution.h"
+
+//------------------------------------------------------------------------------
+//      Method: ResolutionScaler
+//
+// Description: Constructs a ResolutionScaler at full scale. Its framebuffer is
+//              created once the scale first drops.
+//
+//      Inputs: targetFrameTime - The desired time per frame, in seconds.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+ResolutionScaler::ResolutionScaler(double targetFrameTime) {
+  target_ = 0;
+  scaledWidth_ = 0;
+  scaledHeight_ = 0;
+  nFramesSinceChange_ = 0;
+  targetFrameTime_ = targetFrameTime;
+  frameTime_ = 0.0;
+  scale_ = 1.0;
+  isActive_ = false;
+  isSupported_ = true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: begin
+//
+// Description: Starts a frame: the time since the previous frame began is fed
+//              to the controller (see 'adjust'), and if the scale is below
+//              full, the offscreen framebuffer is bound with a viewport (and
+//              scissor box) of the scaled size. The caller then draws the 3D
+//              scene, with projections based on the full window size, and
+//              calls 'end' before drawing the HUD.
+//
+//      Inputs: width, height - The window's size, in pixels.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void ResolutionScaler::begin(int width, int height) {
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+  if (lastFrameTime_ != chrono::steady_clock::time_point()) {
+    adjust(chrono::duration<double>(now - lastFrameTime_).count());
+  }
+  ++nFramesSinceChange_;
+  lastFrameTime_ = now;
+  isActive_ = false;
+  if (scale_ >= 1.0 || !isSupported_) {
+    return;
+  }
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target_);
+  if (!framebuffer_.resize(width, height)) {
+    isSupported_ = false;  // draw at full resolution from now on
+    return;
+  }
+  scaledWidth_ = max(1, (int) (width * scale_ + 0.5));
+  scaledHeight_ = max(1, (int) (height * scale_ + 0.5));
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_.getId());
+  glViewport(0, 0, scaledWidth_, scaledHeight_);
+  glScissor(0, 0, scaledWidth_, scaledHeight_);
+  glEnable(GL_SCISSOR_TEST);
+  isActive_ = true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: end
+//
+// Description: Finishes drawing the 3D scene: if it was drawn at reduced
+//              resolution, it is stretched (with linear filtering) over the
+//              framebuffer recorded by 'begin', whose full viewport is then
+//              restored for the HUD.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void ResolutionScaler::end() {
+  if (!isActive_) {
+    return;
+  }
+  glDisable(GL_SCISSOR_TEST);
+  int width = framebuffer_.getWidth(),
+      height = framebuffer_.getHeight();
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_.getId());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_);
+  glBlitFramebuffer(0, 0, scaledWidth_, scaledHeight_, 0, 0, width, height,
+                    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, target_);
+  glViewport(0, 0, width, height);
+  isActive_ = false;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getScale
+//
+// Description: Returns the fraction of the window's width and height at which
+//              the 3D scene is currently drawn.
+//
+//      Inputs: None.
+//
+//     Outputs: The current scale, from MIN_RESOLUTION_SCALE to 1.
+//------------------------------------------------------------------------------
+double ResolutionScaler::getScale() const {
+  return isSupported_ ? scale_ : 1.0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getFrameTime
+//
+// Description: Returns the average time per frame, as seen by the controller.
+//
+//      Inputs: None.
+//
+//     Outputs: The smoothed frame time, in seconds (0 before the second
+//              frame).
+//------------------------------------------------------------------------------
+double ResolutionScaler::getFrameTime() const {
+  return frameTime_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: adjust
+//
+// Description: A private method that adds a frame time to the running average
+//              and, at most once every RESOLUTION_SETTLE_FRAMES frames (so
+//              that the effect of a change is seen before the next), changes
+//              the scale by at least RESOLUTION_SCALE_STEP toward the one
+//              expected to meet the target frame time. After
+//              RESOLUTION_PROBE_FRAMES frames within budget, the scale is
+//              raised by one step regardless.
+//
+//      Inputs: frameTime - Time taken by the latest frame, in seconds.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void ResolutionScaler::adjust(double frameTime) {
+  frameTime = min(frameTime, 4.0 * targetFrameTime_);  // e.g., window dragged
+  if (frameTime_ <= 0.0) {
+    frameTime_ = frameTime;
+  } else {
+    frameTime_ += (frameTime - frameTime_) * FRAME_TIME_SMOOTHING;
+  }
+  if (nFramesSinceChange_ < RESOLUTION_SETTLE_FRAMES || !isSupported_) {
+    return;
+  }
+
+  double scale = scale_ * sqrt(targetFrameTime_ / frameTime_);
+  if (frameTime_ <= targetFrameTime_ * 1.05 &&
+      nFramesSinceChange_ >= RESOLUTION_PROBE_FRAMES) {
+    scale = max(scale, scale_ + RESOLUTION_SCALE_STEP);
+  }
+  scale = max(MIN_RESOLUTION_SCALE, min(1.0, scale));
+  if (scale != scale_ &&
+      (fabs(scale - scale_) >= RESOLUTION_SCALE_STEP || scale == 1.0 ||
+       scale == MIN_RESOLUTION_SCALE)) {
+    scale_ = scale;
+    nFramesSinceChange_ = 0;
+  }
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+   Filename: resolution.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'ResolutionScaler' class, which holds the frame
+             rate steady on slow (e.g., software-rendered) machines by drawing
+             the 3D scene at reduced resolution. The scene is drawn into the
+             lower-left part of an offscreen framebuffer the size of the
+             window, then stretched over the window in one blit, after which
+             the HUD is drawn at full resolution. The fraction of the window's
+             size used (the scale) is adjusted by a controller that compares
+             the average frame time with a target: since drawing cost grows
+             with the number of pixels, the scale is multiplied by the square
+             root of the ratio of the two. When within budget, the scale is
+             slowly raised again, in case the frame rate is capped by vertical
+             sync (which hides any remaining headroom). At full scale the
+             scene is drawn directly to the window.
+*******************************************************************************/
+
+#ifndef RESOLUTION_H_
+#define RESOLUTION_H_
+
+#include <chrono>
+#include "main.h"
+#include "framebuffer.h"
+
+using namespace std;
+
+const double DEFAULT_TARGET_FRAME_RATE = 60.0;  // frames per second
+const double MIN_RESOLUTION_SCALE = 0.25;
+const double RESOLUTION_SCALE_STEP = 0.05;  // smallest change made
+const double FRAME_TIME_SMOOTHING = 0.1;  // weight of each new frame time
+const int RESOLUTION_SETTLE_FRAMES = 10;  // frames between changes
+const int RESOLUTION_PROBE_FRAMES = 60;  // frames within budget before raising
+
+class ResolutionScaler {
+ public:
+  ResolutionScaler(double targetFrameTime);
+  void begin(int width, int height);
+  void end();
+  double getScale() const;
+  double getFrameTime() const;
+ private:
+  Framebuffer framebuffer_;  // the size of the window
+  GLint target_;  // the framebuffer drawn to before 'begin' (0 for a window)
+  int scaledWidth_,
+      scaledHeight_,
+      nFramesSinceChange_;
+  double targetFrameTime_,
+         frameTime_,  // smoothed
+         scale_;
+  bool isActive_,
+       isSupported_;
+  chrono::steady_clock::time_point lastFrameTime_;
+
+  void adjust(double frameTime);
+};
+
+#endif  // RESOLUTION_H_
@@ -0,0 +1,374 @@
+/*******************************************************************************
+   Filename: simulation.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Simulation' class, which runs the game's
+             simulation on its own thread and publishes its state to the
+             rendering thread through a lock-free triple buffer.
+*******************************************************************************/
+
+#include <mutex>
+#include "simulation.h"
+
+const int FRESH_SNAPSHOT = 4;  // flags a middle slot not yet acquired
+
+//------------------------------------------------------------------------------
+//      Method: interpolate
+//
+// Description: A static helper that blends two states of the same character.
+//              Rotations are blended along the shorter way around the circle.
+//
+//      Inputs: from, to - The character's earlier and later states.
+//              t        - Blend factor, from 0 (earlier) to 1 (later).
+//              result   - Receives the blended state.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+static void interpolate(const CrowdInstance &from, const CrowdInstance &to,
+                        float t, CrowdInstance &result) {
+  float turn = fmod(to.rotation - from.rotation, 360.0f);
+
+  if (turn > 180.0f) {
+    turn -= 360.0f;
+  } else if (turn < -180.0f) {
+    turn += 360.0f;
+  }
+  result = to;
+  result.x = from.x + (to.x - from.x) * t;
+  result.y = from.y + (to.y - from.y) * t;
+  result.z = from.z + (to.z - from.z) * t;
+  result.rotation = from.rotation + turn * t;
+}
+
+//------------------------------------------------------------------------------
+//      Method: SnapshotBuffer
+//
+// Description: Constructs a SnapshotBuffer with no published snapshot.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+SnapshotBuffer::SnapshotBuffer() : middle_(1) {
+  back_ = 0;
+  front_ = 2;
+  for (int i = 0; i < 3; ++i) {
+    slots_[i].time = 0.0;
+    slots_[i].generation = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getBack
+//
+// Description: Returns the slot the producer fills with the next snapshot.
+//              Only the producer may call this.
+//
+//      Inputs: None.
+//
+//     Outputs: The back slot's snapshot.
+//------------------------------------------------------------------------------
+Snapshot &SnapshotBuffer::getBack() {
+  return slots_[back_];
+}
+
+//------------------------------------------------------------------------------
+//      Method: publish
+//
+// Description: Makes the back slot's snapshot the latest one, replacing any
+//              the consumer has not yet acquired, and takes a free slot as the
+//              new back slot. Only the producer may call this.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void SnapshotBuffer::publish() {
+  back_ = middle_.exchange(back_ | FRESH_SNAPSHOT, memory_order_acq_rel) &
+          ~FRESH_SNAPSHOT;
+}
+
+//------------------------------------------------------------------------------
+//      Method: acquire
+//
+// Description: Makes the latest published snapshot, if not already acquired,
+//              the front one. Only the consumer may call this.
+//
+//      Inputs: previous - Receives the former front snapshot if a new one was
+//                         acquired (its own contents are discarded).
+//
+//     Outputs: Returns 'true' if a new snapshot was acquired, 'false' if the
+//              front one is still the latest.
+//------------------------------------------------------------------------------
+bool SnapshotBuffer::acquire(Snapshot &previous) {
+  if (!(middle_.load(memory_order_acquire) & FRESH_SNAPSHOT)) {
+    return false;
+  }
+
+  // the old front slot must be emptied before the producer can reclaim it
+  swap(previous, slots_[front_]);
+  front_ = middle_.exchange(front_, memory_order_acq_rel) & ~FRESH_SNAPSHOT;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getFront
+//
+// Description: Returns the most recently acquired snapshot. Only the consumer
+//              may call this.
+//
+//      Inputs: None.
+//
+//     Outputs: The front slot's snapshot.
+//------------------------------------------------------------------------------
+const Snapshot &SnapshotBuffer::getFront() const {
+  return slots_[front_];
+}
+
+//------------------------------------------------------------------------------
+//      Method: Simulation
+//
+// Description: Constructs a stopped Simulation of a given quest and player.
+//
+//      Inputs: quest  - The quest to be simulated.
+//              player - The player character.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Simulation::Simulation(Quest *quest, Character *player)
+    : isRunning_(false), isQuestComplete_(false) {
+  quest_ = quest;
+  player_ = player;
+  previous_.time = 0.0;
+  previous_.generation = -1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~Simulation
+//
+// Description: Destructs the Simulation, stopping its thread first.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Simulation::~Simulation() {
+  stop();
+}
+
+//------------------------------------------------------------------------------
+//      Method: start
+//
+// Description: Publishes a snapshot of the initial state, so that a frame is
+//              available at once, then starts the simulation thread. While it
+//              runs, the quest's characters must not be touched by any other
+//              thread, except through the infinite world's mutex (see
+//              'World::getMutex').
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::start() {
+  if (isRunning_) {
+    return;
+  }
+  startTime_ = chrono::steady_clock::now();
+  {
+    unique_lock<mutex> lock;
+    if (quest_->getWorld()) {
+      lock = unique_lock<mutex>(quest_->getWorld()->getMutex());
+    }
+    capture(buffer_.getBack(), 0.0);
+  }
+  buffer_.publish();
+  isRunning_ = true;
+  thread_ = thread(&Simulation::run, this);
+}
+
+//------------------------------------------------------------------------------
+//      Method: stop
+//
+// Description: Stops the simulation thread and waits for it to finish its
+//              current tick.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::stop() {
+  isRunning_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: isQuestComplete
+//
+// Description: Determines whether the player has completed the quest, which
+//              also ends the simulation.
+//
+//      Inputs: None.
+//
+//     Outputs: Returns 'true' if the quest has been completed.
+//------------------------------------------------------------------------------
+bool Simulation::isQuestComplete() const {
+  return isQuestComplete_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getFrame
+//
+// Description: Produces the state to be drawn now: the simulation one tick ago,
+//              interpolated between the two latest snapshots. Characters are
+//              not interpolated across a change in the set of characters.
+//              Never waits for the simulation thread. Only the rendering
+//              thread may call this.
+//
+//      Inputs: frame - Receives the interpolated state.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::getFrame(Snapshot &frame) {
+  buffer_.acquire(previous_);
+
+  const Snapshot &latest = buffer_.getFront();
+  double time = chrono::duration<double>(chrono::steady_clock::now() -
+                                         startTime_).count() -
+                1.0 / SIMULATION_RATE;
+  float t = 1.0f;
+
+  if (previous_.generation >= 0 && latest.time > previous_.time) {
+    t = (float) ((time - previous_.time) / (latest.time - previous_.time));
+    t = max(0.0f, min(1.0f, t));
+  }
+  frame.time = min(time, latest.time);
+  frame.generation = latest.generation;
+  interpolate(previous_.generation >= 0 ? previous_.player : latest.player,
+              latest.player, t, frame.player);
+  frame.characters.resize(latest.characters.size());
+  if (previous_.generation == latest.generation &&
+      previous_.characters.size() == latest.characters.size()) {
+    for (size_t i = 0; i < latest.characters.size(); ++i) {
+      interpolate(previous_.characters[i], latest.characters[i], t,
+                  frame.characters[i]);
+    }
+  } else {
+    copy(latest.characters.begin(), latest.characters.end(),
+         frame.characters.begin());
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: run
+//
+// Description: A private method run by the simulation thread. Ticks at
+//              SIMULATION_RATE ticks per second, publishing a snapshot after
+//              each tick, until stopped or the quest is completed. If the
+//              simulation falls more than MAX_SIMULATION_LAG ticks behind, the
+//              missed ticks are dropped rather than run back to back.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::run() {
+  chrono::steady_clock::duration period =
+    chrono::duration_cast<chrono::steady_clock::duration>(
+      chrono::duration<double>(1.0 / SIMULATION_RATE));
+  chrono::steady_clock::time_point tickTime = startTime_;
+
+  while (isRunning_ && !isQuestComplete_) {
+    tickTime += period;
+    this_thread::sleep_until(tickTime);
+    if (chrono::steady_clock::now() - tickTime > MAX_SIMULATION_LAG * period) {
+      tickTime = chrono::steady_clock::now();
+    }
+    {
+      unique_lock<mutex> lock;
+      if (quest_->getWorld()) {
+        lock = unique_lock<mutex>(quest_->getWorld()->getMutex());
+      }
+      tick();
+      capture(buffer_.getBack(),
+              chrono::duration<double>(tickTime - startTime_).count());
+    }
+    buffer_.publish();
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: tick
+//
+// Description: A private method that advances the simulation by one step:
+//              checks for quest completion, applies gravity and the player's
+//              input to the player, and lets every NPC act.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::tick() {
+  // check for level completion (infinite quests have no finish)
+  if (isKeyPressed('e') && !quest_->isInfinite() &&
+      player_->getNextX() > quest_->getFinishX() &&
+      player_->getNextX() < (quest_->getFinishX() + 1.0) &&
+      player_->getNextY() > (quest_->getHeight() - 2.0)) {
+    isQuestComplete_ = true;
+    return;
+  }
+
+  // check for gravity effects
+  if (player_->isOnGround() == false) {
+    player_->fall();
+  }
+
+  // check for user input
+  if (isKeyPressed(KEY_SPACE) && player_->isOnGround()) {
+    player_->jump();
+  }
+  if (isKeyPressed(KEY_UP) || isKeyPressed('w')) {
+    player_->moveForward();
+  }
+  if (isKeyPressed(KEY_DOWN) || isKeyPressed('s')) {
+    player_->moveBackward();
+  }
+  if (isKeyPressed('z')) {
+    player_->strafeLeft();
+  }
+  if (isKeyPressed('c')) {
+    player_->strafeRight();
+  }
+  if (isKeyPressed(KEY_LEFT) || isKeyPressed('a')) {
+    player_->rotateLeft();
+  }
+  if (isKeyPressed(KEY_RIGHT) || isKeyPressed('d')) {
+    player_->rotateRight();
+  }
+
+  quest_->act();
+}
+
+//------------------------------------------------------------------------------
+//      Method: capture
+//
+// Description: A private method that records the current state of every
+//              character in a given snapshot.
+//
+//      Inputs: snapshot - The snapshot to be filled.
+//              time     - The snapshot's time, in seconds since the
+//                         simulation started.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Simulation::capture(Snapshot &snapshot, double time) {
+  snapshot.time = time;
+  snapshot.generation = quest_->getWorld() ?
+                        quest_->getWorld()->getGeneration() : 0;
+  snapshot.player = getCrowdInstance(player_);
+  snapshot.characters.clear();
+  quest_->getCharacters(snapshot.characters);
+}
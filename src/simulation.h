@@ -0,0 +1,84 @@
+/*******************************************************************************
+   Filename: simulation.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Simulation' class, which runs the game's
+             simulation (player input, gravity, and NPC behavior) on its own
+             thread at a fixed rate of SIMULATION_RATE ticks per second. After
+             each tick, the state of every character is published as an
+             immutable snapshot through a lock-free triple buffer
+             ('SnapshotBuffer'), from which the rendering thread takes the
+             latest snapshot without ever waiting. Frames are drawn one tick
+             behind the simulation, interpolated between the two latest
+             snapshots, so motion stays smooth at any frame rate. A slow frame
+             thus no longer slows the simulation, and a slow tick no longer
+             delays a frame.
+*******************************************************************************/
+
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "quest.h"
+
+using namespace std;
+
+class Quest;
+class Character;
+
+const double SIMULATION_RATE = 60.0;  // ticks per second
+const int MAX_SIMULATION_LAG = 5;  // ticks skipped, not caught up, beyond this
+
+// The state of every character after a given simulation tick.
+struct Snapshot {
+  double time;     // seconds since the simulation started
+  int generation;  // changes whenever the set of characters changes
+  CrowdInstance player;
+  vector<CrowdInstance> characters;
+};
+
+// A single-producer, single-consumer triple buffer: the producer fills the
+// back slot and swaps it with the middle one; the consumer swaps the middle
+// slot (if it is newer) with the front one. Neither side ever blocks.
+class SnapshotBuffer {
+ public:
+  SnapshotBuffer();
+  Snapshot &getBack();
+  void publish();
+  bool acquire(Snapshot &previous);
+  const Snapshot &getFront() const;
+ private:
+  Snapshot slots_[3];
+  atomic<int> middle_;  // index of the middle slot, plus FRESH_SNAPSHOT
+  int back_,
+      front_;
+};
+
+class Simulation {
+ public:
+  Simulation(Quest *quest, Character *player);
+  ~Simulation();
+  void start();
+  void stop();
+  bool isQuestComplete() const;
+  void getFrame(Snapshot &frame);
+ private:
+  Quest *quest_;
+  Character *player_;
+  SnapshotBuffer buffer_;
+  Snapshot previous_;  // the snapshot before the buffer's front one
+  thread thread_;
+  atomic<bool> isRunning_,
+               isQuestComplete_;
+  chrono::steady_clock::time_point startTime_;
+
+  void run();
+  void tick();
+  void capture(Snapshot &snapshot, double time);
+};
+
+#endif  // SIMULATION_H_
@@ -0,0 +1,334 @@
+/*******************************************************************************
+   Filename: visibility.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'Visibility' class, which finds the cells of a
+             quest's maze that can be seen from a given cell by portal
+             traversal.
+*******************************************************************************/
+
+#include <cmath>
+#include "visibility.h"
+
+//------------------------------------------------------------------------------
+//      Method: Visibility
+//
+// Description: Constructs a Visibility object for a given quest. No visible set
+//              exists until 'update' is called.
+//
+//      Inputs: quest - The quest whose maze is to be traversed.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+Visibility::Visibility(const Quest *quest) {
+  quest_ = quest;
+  cellIndex_ = -1;
+  minX_ = minY_ = maxX_ = maxY_ = 0;
+  mask_.assign(quest->getWidth() * quest->getHeight(), 0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: update
+//
+// Description: Ensures the visible set is that of a given cell, i.e., every
+//              cell that a sight line from some point within the given cell
+//              can reach without crossing a wall (see 'traverse'). The set
+//              holds for any eye position within the cell, so it never misses
+//              a visible cell. Nothing is done if the set is already that of
+//              the given cell.
+//
+//      Inputs: x, y - Coordinates of the viewer's cell (clamped to the maze).
+//
+//     Outputs: Returns 'true' if the visible set was recomputed, 'false' if the
+//              cached set was still valid.
+//------------------------------------------------------------------------------
+bool Visibility::update(int x, int y) {
+  x = max(0, min(x, quest_->getWidth() - 1));
+  y = max(0, min(y, quest_->getHeight() - 1));
+  int cellIndex = quest_->getCellIndex(x, y);
+  if (cellIndex == cellIndex_) {
+    return false;
+  }
+
+  for (size_t i = 0; i < visibleCells_.size(); ++i) {
+    mask_[visibleCells_[i]] = 0;
+  }
+  visibleCells_.clear();
+  cellIndex_ = cellIndex;
+  minX_ = maxX_ = x;
+  minY_ = maxY_ = y;
+  markVisible(cellIndex);
+  traverse(cellIndex);
+  ++maxX_;
+  ++maxY_;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//      Method: invalidate
+//
+// Description: Discards the cached visible set (e.g., after a wall changes), so
+//              that the next 'update' recomputes it.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Visibility::invalidate() {
+  cellIndex_ = -1;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isVisible
+//
+// Description: Determines whether a given cell is in the current visible set.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//
+//     Outputs: Returns 'true' if the cell is visible, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool Visibility::isVisible(int cellIndex) const {
+  return cellIndex >= 0 && cellIndex < mask_.size() && mask_[cellIndex];
+}
+
+//------------------------------------------------------------------------------
+//      Method: getVisibleCells
+//
+// Description: Returns the indices of the cells in the current visible set.
+//
+//      Inputs: None.
+//
+//     Outputs: The visible cells' indices, in no particular order.
+//------------------------------------------------------------------------------
+const vector<int> &Visibility::getVisibleCells() const {
+  return visibleCells_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getMask
+//
+// Description: Returns the visibility of every cell of the maze as an array
+//              indexed like the quest's cells (1 if visible, 0 otherwise).
+//
+//      Inputs: None.
+//
+//     Outputs: A pointer to the first cell's entry.
+//------------------------------------------------------------------------------
+const unsigned char *Visibility::getMask() const {
+  return &mask_[0];
+}
+
+//------------------------------------------------------------------------------
+//      Method: getBounds
+//
+// Description: Returns the smallest rectangle of cells containing the current
+//              visible set.
+//
+//      Inputs: None.
+//
+//     Outputs: minX, minY - Coordinates of the rectangle's first cell.
+//              maxX, maxY - Coordinates just beyond its last cell.
+//------------------------------------------------------------------------------
+void Visibility::getBounds(int &minX, int &minY, int &maxX, int &maxY) const {
+  minX = minX_;
+  minY = minY_;
+  maxX = maxX_;
+  maxY = maxY_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: markVisible
+//
+// Description: A private method that adds a cell to the visible set (if it is
+//              not already there).
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Visibility::markVisible(int cellIndex) {
+  if (!mask_[cellIndex]) {
+    int x = cellIndex % quest_->getWidth(),
+        y = cellIndex / quest_->getWidth();
+    mask_[cellIndex] = 1;
+    visibleCells_.push_back(cellIndex);
+    minX_ = min(minX_, x);
+    minY_ = min(minY_, y);
+    maxX_ = max(maxX_, x);
+    maxY_ = max(maxY_, y);
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: traverse
+//
+// Description: A private method that marks every cell reachable by a sight
+//              line from some point within a given cell. Each portal of the
+//              cell starts a depth-first traversal of chains of portals. Any
+//              line through a portal enters the cell behind it, so a chain
+//              leads to a visible cell exactly when some line passes through
+//              every portal in it, crossing each in the direction of travel:
+//              i.e., when a directed line has every portal's left end on its
+//              left and every right end on its right. If such a line exists,
+//              one exists through two of the ends (slide it sideways until it
+//              meets one, then turn it about that one until it meets
+//              another), so only those lines need be kept (see 'extend'). A
+//              line never heads both north and south (or east and west), so
+//              neither does a chain; this also keeps a chain whose only lines
+//              touch a corner (within VISIBILITY_EPSILON) from circling it.
+//
+//      Inputs: cellIndex - Index of the viewer's cell.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void Visibility::traverse(int cellIndex) {
+  VisibilityPath start;
+
+  start.cellIndex = cellIndex;
+  start.sides = 0;
+  for (int side = NORTH; side <= WEST; ++side) {
+    VisibilityPath path;
+    if (!extend(start, side, path)) {
+      continue;
+    }
+    stack_.push_back(path);
+    while (!stack_.empty()) {
+      path = stack_.back();
+      stack_.pop_back();
+      markVisible(path.cellIndex);
+      for (int next = NORTH; next <= WEST; ++next) {
+        VisibilityPath extended;
+        if (extend(path, next, extended)) {
+          stack_.push_back(extended);
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: extend
+//
+// Description: A private method that extends a chain of portals through one
+//              more portal of its last cell, keeping those of its lines that
+//              pass through the new portal as well and adding those through
+//              one of the new portal's ends that pass through every portal.
+//
+//      Inputs: path - The chain so far.
+//              side - Integer representing the side of the chain's last cell
+//                     through which it is to be extended (NORTH, SOUTH, EAST,
+//                     or WEST).
+//
+//     Outputs: out - The extended chain (if any).
+//              Returns 'true' if some line passes through every portal of the
+//              extended chain, 'false' if none does, the side is a wall, or
+//              the chain has already headed the opposite way.
+//------------------------------------------------------------------------------
+bool Visibility::extend(const VisibilityPath &path, int side,
+                        VisibilityPath &out) const {
+  int neighbor = quest_->getNeighborIndex(path.cellIndex, side);
+  if (neighbor < 0 || quest_->getCell(path.cellIndex).hasWallAt(side) ||
+      (path.sides & (1 << oppositeSide(side)))) {
+    return false;
+  }
+
+  // the portal's first end (as given by 'getPortal') is on the left when
+  // heading north or west, on the right when heading south or east
+  double x1, y1, x2, y2;
+  getPortal(path.cellIndex, side, x1, y1, x2, y2);
+  bool isFirstLeft = (side == NORTH || side == WEST);
+  VisibilityPoint ends[2] = {{x1, y1, isFirstLeft}, {x2, y2, !isFirstLeft}};
+
+  out.cellIndex = neighbor;
+  out.sides = path.sides | (1 << side);
+  out.points = path.points;
+  out.points.push_back(ends[0]);
+  out.points.push_back(ends[1]);
+  out.lines.clear();
+  for (size_t i = 0; i < path.lines.size(); ++i) {
+    if (isSeparating(path.lines[i], out.points)) {
+      out.lines.push_back(path.lines[i]);
+    }
+  }
+  for (int e = 0; e < 2; ++e) {
+    for (size_t i = 0; i + 2 - e < out.points.size(); ++i) {
+      const VisibilityPoint &a = ends[e],
+                            &b = out.points[i];
+      if (fabs(b.x - a.x) + fabs(b.y - a.y) < VISIBILITY_EPSILON) {
+        continue;  // a corner shared by consecutive portals
+      }
+      for (int sign = -1; sign <= 1; sign += 2) {
+        VisibilityLine line = {a.x, a.y, sign * (b.x - a.x),
+                               sign * (b.y - a.y)};
+        if (isSeparating(line, out.points)) {
+          out.lines.push_back(line);
+        }
+      }
+    }
+  }
+
+  return !out.lines.empty();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getPortal
+//
+// Description: A private method that returns the endpoints of the segment
+//              shared by a cell and its neighbor on a given side.
+//
+//      Inputs: cellIndex - Index of the cell of interest.
+//              side      - Integer representing the side of interest (NORTH,
+//                          SOUTH, EAST, or WEST).
+//
+//     Outputs: x1, y1, x2, y2 - The segment's endpoints, measured in cells.
+//------------------------------------------------------------------------------
+void Visibility::getPortal(int cellIndex, int side, double &x1, double &y1,
+                           double &x2, double &y2) const {
+  int x = cellIndex % quest_->getWidth(),
+      y = cellIndex / quest_->getWidth();
+
+  x1 = x2 = x;
+  y1 = y2 = y;
+  if (side == NORTH || side == SOUTH) {
+    ++x2;
+    if (side == NORTH) {
+      ++y1;
+      ++y2;
+    }
+  } else {
+    ++y2;
+    if (side == EAST) {
+      ++x1;
+      ++x2;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: isSeparating
+//
+// Description: A private static method that determines whether a directed
+//              line has each of a set of portal ends on the proper side (left
+//              ends to its left, right ends to its right, or on the line).
+//
+//      Inputs: line   - The line of interest.
+//              points - The portal ends.
+//
+//     Outputs: Returns 'true' if every end is on its proper side, 'false'
+//              otherwise.
+//------------------------------------------------------------------------------
+bool Visibility::isSeparating(const VisibilityLine &line,
+                              const vector<VisibilityPoint> &points) {
+  for (size_t i = 0; i < points.size(); ++i) {
+    double cross = line.dx * (points[i].y - line.y) -
+                   line.dy * (points[i].x - line.x);
+    if (points[i].isLeft ? cross < -VISIBILITY_EPSILON :
+                           cross > VISIBILITY_EPSILON) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+   Filename: visibility.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'Visibility' class, which finds the cells of a
+             quest's maze that can be seen from anywhere within a given cell
+             by traversing its portals (the openings between cells): a chain
+             of portals is followed for as long as some straight line passes
+             through every portal in it. The visible set is cached until the
+             viewer changes cells.
+*******************************************************************************/
+
+#ifndef VISIBILITY_H_
+#define VISIBILITY_H_
+
+#include <vector>
+#include "quest.h"
+
+using namespace std;
+
+class Quest;
+
+const double VISIBILITY_EPSILON = 1e-9;  // tolerance of the side tests
+
+// An end of a portal, on the left or right as seen when crossing it.
+struct VisibilityPoint {
+  double x,
+         y;
+  bool isLeft;
+};
+
+// A directed line through two portal ends.
+struct VisibilityLine {
+  double x,
+         y,
+         dx,
+         dy;
+};
+
+// A chain of portals leading from the viewer's cell into a cell, with every
+// line through two of their ends that passes through all of them (see
+// 'Visibility::traverse').
+struct VisibilityPath {
+  int cellIndex,
+      sides;  // bit mask of the directions (NORTH, etc.) headed so far
+  vector<VisibilityPoint> points;
+  vector<VisibilityLine> lines;
+};
+
+class Visibility {
+ public:
+  Visibility(const Quest *quest);
+  bool update(int x, int y);
+  void invalidate();
+  bool isVisible(int cellIndex) const;
+  const vector<int> &getVisibleCells() const;
+  const unsigned char *getMask() const;
+  void getBounds(int &minX, int &minY, int &maxX, int &maxY) const;
+ private:
+  const Quest *quest_;
+  int cellIndex_,
+      minX_,
+      minY_,
+      maxX_,  // exclusive
+      maxY_;  // exclusive
+  vector<int> visibleCells_;
+  vector<unsigned char> mask_;  // per cell, 1 if visible
+  vector<VisibilityPath> stack_;
+
+  void markVisible(int cellIndex);
+  void traverse(int cellIndex);
+  bool extend(const VisibilityPath &path, int side, VisibilityPath &out) const;
+  void getPortal(int cellIndex, int side, double &x1, double &y1, double &x2,
+                 double &y2) const;
+  static bool isSeparating(const VisibilityLine &line,
+                           const vector<VisibilityPoint> &points);
+};
+
+#endif  // VISIBILITY_H_
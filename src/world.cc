@@ -0,0 +1,458 @@
+/*******************************************************************************
+   Filename: world.cc
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Definition of a 'World' class representing an unbounded dungeon
+             made of fixed-size chunks, which are generated on demand around
+             the player and evicted once the player moves far away.
+*******************************************************************************/
+
+#include "world.h"
+
+//------------------------------------------------------------------------------
+//      Method: floorDiv
+//
+// Description: Divides one integer by another, rounding toward negative
+//              infinity (so that negative cell coordinates map to the correct
+//              chunk).
+//
+//      Inputs: a - Dividend.
+//              b - Divisor (must be positive).
+//
+//     Outputs: The rounded-down quotient.
+//------------------------------------------------------------------------------
+static int floorDiv(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getChunkKey
+//
+// Description: Packs a pair of chunk coordinates into a single hash key.
+//
+//      Inputs: chunkX, chunkY - Chunk coordinates, measured in chunks.
+//
+//     Outputs: The chunk's key.
+//------------------------------------------------------------------------------
+static uint64_t getChunkKey(int chunkX, int chunkY) {
+  return ((uint64_t) (uint32_t) chunkX << 32) | (uint32_t) chunkY;
+}
+
+//------------------------------------------------------------------------------
+//      Method: World
+//
+// Description: Constructs an empty World. No chunks exist until 'update' is
+//              first called.
+//
+//      Inputs: quest        - Pointer to the quest that owns this world (used
+//                             for spawning NPCs).
+//              seed         - Seed from which every chunk is derived.
+//              viewDistance - Number of chunks kept loaded in each direction
+//                             beyond the one the player occupies.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+World::World(Quest *quest, uint64_t seed, int viewDistance) {
+  quest_ = quest;
+  seed_ = seed;
+  viewDistance_ = viewDistance;
+  generation_ = 0;
+}
+
+//------------------------------------------------------------------------------
+//      Method: ~World
+//
+// Description: Destructs the World object, along with all loaded chunks and
+//              their NPCs.
+//
+//      Inputs: None.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+World::~World() {
+  unordered_map<uint64_t, Chunk *>::iterator iter;
+  for (iter = chunks_.begin(); iter != chunks_.end(); ++iter) {
+    deleteChunk(iter->second);
+  }
+  chunks_.clear();
+}
+
+//------------------------------------------------------------------------------
+//      Method: update
+//
+// Description: Ensures every chunk within the view distance of a given
+//              position is loaded, generating any that are missing, and evicts
+//              chunks more than one chunk beyond the view distance (the extra
+//              margin keeps chunks from thrashing along a border). Memory and
+//              generation cost thus depend only on the view distance. Holds the
+//              world's mutex, since the simulation thread may be moving NPCs.
+//
+//      Inputs: x, y - The player's position, measured in cells.
+//
+//     Outputs: The number of chunks generated.
+//------------------------------------------------------------------------------
+int World::update(double x, double y) {
+  int playerChunkX = floorDiv((int) floor(x), CHUNK_SIZE);
+  int playerChunkY = floorDiv((int) floor(y), CHUNK_SIZE);
+  int nGenerated = 0,
+      nEvicted = 0;
+  lock_guard<mutex> lock(mutex_);
+
+  for (int chunkY = playerChunkY - viewDistance_;
+       chunkY <= playerChunkY + viewDistance_; ++chunkY) {
+    for (int chunkX = playerChunkX - viewDistance_;
+         chunkX <= playerChunkX + viewDistance_; ++chunkX) {
+      uint64_t key = getChunkKey(chunkX, chunkY);
+      if (chunks_.find(key) == chunks_.end()) {
+        chunks_[key] = generateChunk(chunkX, chunkY);
+        ++nGenerated;
+      }
+    }
+  }
+
+  unordered_map<uint64_t, Chunk *>::iterator iter = chunks_.begin();
+  while (iter != chunks_.end()) {
+    Chunk *chunk = iter->second;
+    if (abs(chunk->chunkX - playerChunkX) > viewDistance_ + 1 ||
+        abs(chunk->chunkY - playerChunkY) > viewDistance_ + 1) {
+      deleteChunk(chunk);
+      iter = chunks_.erase(iter);
+      ++nEvicted;
+    } else {
+      ++iter;
+    }
+  }
+  if (nGenerated > 0 || nEvicted > 0) {
+    ++generation_;
+  }
+
+  return nGenerated;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getNumLoadedChunks
+//
+// Description: Returns the number of chunks currently held in memory.
+//
+//      Inputs: None.
+//
+//     Outputs: The number of loaded chunks.
+//------------------------------------------------------------------------------
+int World::getNumLoadedChunks() const {
+  return chunks_.size();
+}
+
+//------------------------------------------------------------------------------
+//      Method: getGeneration
+//
+// Description: Returns a number that changes whenever chunks (and thus NPCs)
+//              are loaded or evicted.
+//
+//      Inputs: None.
+//
+//     Outputs: The current generation of the set of loaded chunks.
+//------------------------------------------------------------------------------
+int World::getGeneration() const {
+  return generation_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getMutex
+//
+// Description: Returns the mutex that must be held while moving NPCs, or while
+//              testing positions, on any thread other than the one calling
+//              'update'.
+//
+//      Inputs: None.
+//
+//     Outputs: The world's mutex.
+//------------------------------------------------------------------------------
+mutex &World::getMutex() {
+  return mutex_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getViewDistance
+//
+// Description: Returns the number of chunks kept loaded in each direction
+//              beyond the one the player occupies.
+//
+//      Inputs: None.
+//
+//     Outputs: The view distance, measured in chunks.
+//------------------------------------------------------------------------------
+int World::getViewDistance() const {
+  return viewDistance_;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCell
+//
+// Description: Returns the cell at a given set of world coordinates, if the
+//              chunk containing it is loaded.
+//
+//      Inputs: x, y - Coordinates of the cell of interest (may be negative).
+//
+//     Outputs: A pointer to the cell, or NULL if its chunk is not loaded.
+//------------------------------------------------------------------------------
+const Cell *World::getCell(int x, int y) const {
+  int chunkX = floorDiv(x, CHUNK_SIZE), chunkY = floorDiv(y, CHUNK_SIZE);
+  unordered_map<uint64_t, Chunk *>::const_iterator iter =
+    chunks_.find(getChunkKey(chunkX, chunkY));
+
+  if (iter == chunks_.end()) {
+    return NULL;
+  }
+
+  return &iter->second->cells[(x - chunkX * CHUNK_SIZE) +
+                              (y - chunkY * CHUNK_SIZE) * CHUNK_SIZE];
+}
+
+//------------------------------------------------------------------------------
+//      Method: isLegalPosition
+//
+// Description: Determines whether a given (x, y) position is a legal location
+//              for a Character with a given collision radius to exist. Cells
+//              in unloaded chunks are treated as solid.
+//
+//      Inputs: x, y   - Coordinates of the position to be tested.
+//              radius - Collision radius of the Character whose position is
+//                       being tested.
+//
+//     Outputs: Returns 'true' if the position is legal, 'false' otherwise.
+//------------------------------------------------------------------------------
+bool World::isLegalPosition(double x, double y, double radius) const {
+  int cellX = (int) floor(x), cellY = (int) floor(y);
+  const Cell *cell = getCell(cellX, cellY);
+  double offsetX = x - cellX;
+  double offsetY = y - cellY;
+
+  if (!cell) {
+    return false;
+  }
+
+  return !(cell->hasWallAt(NORTH) && offsetY + radius > 1.0) &&
+         !(cell->hasWallAt(SOUTH) && offsetY - radius < 0.0) &&
+         !(cell->hasWallAt(EAST) && offsetX + radius > 1.0) &&
+         !(cell->hasWallAt(WEST) && offsetX - radius < 0.0);
+}
+
+//------------------------------------------------------------------------------
+//      Method: queueMeshes
+//
+// Description: Adds the mesh of every loaded chunk within the view frustum to a
+//              render queue, baking the chunk's geometry into a mesh the first
+//              time it is needed. Chunks outside the frustum are skipped, along
+//              with their NPCs (see 'isVisible').
+//
+//      Inputs: queue            - The render queue of the current frame.
+//              frustum          - The camera's view frustum.
+//              viewerX, viewerY - The viewer's location.
+//
+//     Outputs: The number of chunks queued.
+//------------------------------------------------------------------------------
+int World::queueMeshes(RenderQueue &queue, const Frustum &frustum,
+                       double viewerX, double viewerY) {
+  unordered_map<uint64_t, Chunk *>::iterator iter;
+  int nQueued = 0;
+
+  for (iter = chunks_.begin(); iter != chunks_.end(); ++iter) {
+    Chunk *chunk = iter->second;
+    int minX = chunk->chunkX * CHUNK_SIZE,
+        minY = chunk->chunkY * CHUNK_SIZE;
+    chunk->isVisible = frustum.isBoxVisible(minX, minY, 0.0,
+                                            minX + CHUNK_SIZE,
+                                            minY + CHUNK_SIZE, 1.0);
+    if (!chunk->isVisible) {
+      continue;
+    }
+    if (!chunk->mesh) {
+      int layers[NUM_MATERIALS];
+      for (int m = 0; m < NUM_MATERIALS; ++m) {
+        layers[m] = quest_->getMaterialIndex(m);
+      }
+      chunk->mesh = new MazeMesh();
+      chunk->mesh->build(&chunk->cells[0], CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE,
+                         minX, minY, layers);
+    }
+    queue.add(chunk->mesh, viewerX, viewerY);
+    ++nQueued;
+  }
+
+  return nQueued;
+}
+
+//------------------------------------------------------------------------------
+//      Method: isVisible
+//
+// Description: Determines whether a given position lies within a chunk found
+//              within the view frustum by the most recent 'queueMeshes'.
+//
+//      Inputs: x, y - The position of interest, measured in cells.
+//
+//     Outputs: Returns 'true' if the position's chunk is loaded and visible.
+//------------------------------------------------------------------------------
+bool World::isVisible(double x, double y) const {
+  unordered_map<uint64_t, Chunk *>::const_iterator iter =
+    chunks_.find(getChunkKey(floorDiv((int) floor(x), CHUNK_SIZE),
+                             floorDiv((int) floor(y), CHUNK_SIZE)));
+
+  return iter != chunks_.end() && iter->second->isVisible;
+}
+
+//------------------------------------------------------------------------------
+//      Method: act
+//
+// Description: Executes AI behavior for the NPCs of every loaded chunk. The
+//              caller must hold the world's mutex.
+//
+//      Inputs: player - Pointer to the player character.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void World::act(Character *player) {
+  unordered_map<uint64_t, Chunk *>::iterator iter;
+
+  for (iter = chunks_.begin(); iter != chunks_.end(); ++iter) {
+    vector<Character *> &characters = iter->second->characters;
+    for (size_t i = 0; i < characters.size(); ++i) {
+      characters[i]->act(player);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: getCharacters
+//
+// Description: Appends the current state of the NPCs of every loaded chunk to
+//              a given list. The caller must hold the world's mutex.
+//
+//      Inputs: instances - The list to which the NPCs are appended.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void World::getCharacters(vector<CrowdInstance> &instances) const {
+  unordered_map<uint64_t, Chunk *>::const_iterator iter;
+
+  for (iter = chunks_.begin(); iter != chunks_.end(); ++iter) {
+    const vector<Character *> &characters = iter->second->characters;
+    for (size_t i = 0; i < characters.size(); ++i) {
+      instances.push_back(getCrowdInstance(characters[i]));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//      Method: generateChunk
+//
+// Description: A private method that creates the chunk at a given set of chunk
+//              coordinates. The chunk's interior is a perfect maze derived only
+//              from the world seed and the chunk's coordinates, so an evicted
+//              chunk is regenerated identically. Each of its four borders gets
+//              one door whose position is derived from the border itself, so
+//              both chunks sharing a border always agree on it. NPCs for the
+//              chunk are spawned here as well.
+//
+//      Inputs: chunkX, chunkY - Chunk coordinates, measured in chunks.
+//
+//     Outputs: A pointer to the newly created chunk.
+//------------------------------------------------------------------------------
+Chunk *World::generateChunk(int chunkX, int chunkY) {
+  Chunk *chunk = new Chunk;
+  Random random(getChunkSeed(chunkX, chunkY, NUM_SIDES));
+  EllerGenerator rows(CHUNK_SIZE, CHUNK_SIZE, random.split());
+  int last = CHUNK_SIZE - 1;
+
+  chunk->chunkX = chunkX;
+  chunk->chunkY = chunkY;
+  chunk->mesh = NULL;
+  chunk->isVisible = false;
+  chunk->cells.resize(CHUNK_SIZE * CHUNK_SIZE);
+  for (int j = 0; j < CHUNK_SIZE; ++j) {
+    rows.nextRow(&chunk->cells[j * CHUNK_SIZE]);
+  }
+
+  // open the doors shared with neighboring chunks
+  chunk->cells[getDoorOffset(chunkX, chunkY, NORTH) + last * CHUNK_SIZE]
+    .removeWall(NORTH);
+  chunk->cells[getDoorOffset(chunkX, chunkY, SOUTH)].removeWall(SOUTH);
+  chunk->cells[last + getDoorOffset(chunkX, chunkY, EAST) * CHUNK_SIZE]
+    .removeWall(EAST);
+  chunk->cells[getDoorOffset(chunkX, chunkY, WEST) * CHUNK_SIZE]
+    .removeWall(WEST);
+
+  // spawn NPCs
+  for (int i = 0; i < NPCS_PER_CHUNK; ++i) {
+    Character *npc = new Character(GOBLIN, quest_);
+    npc->setPosition(chunkX * CHUNK_SIZE + random.nextInt(CHUNK_SIZE) +
+                       CELL_SIZE / 2.0,
+                     chunkY * CHUNK_SIZE + random.nextInt(CHUNK_SIZE) +
+                       CELL_SIZE / 2.0,
+                     random.nextInt(360));
+    chunk->characters.push_back(npc);
+  }
+
+  return chunk;
+}
+
+//------------------------------------------------------------------------------
+//      Method: deleteChunk
+//
+// Description: A private method that destroys a chunk, its mesh, and its NPCs.
+//
+//      Inputs: chunk - Pointer to the chunk to be destroyed.
+//
+//     Outputs: None.
+//------------------------------------------------------------------------------
+void World::deleteChunk(Chunk *chunk) {
+  for (size_t i = 0; i < chunk->characters.size(); ++i) {
+    delete chunk->characters[i];
+  }
+  delete chunk->mesh;
+  delete chunk;
+}
+
+//------------------------------------------------------------------------------
+//      Method: getDoorOffset
+//
+// Description: A private method that returns the position of the door along a
+//              given border of a given chunk. A chunk's SOUTH and WEST borders
+//              are looked up as the NORTH and EAST borders of its neighbors, so
+//              the result is the same from either side.
+//
+//      Inputs: chunkX, chunkY - Chunk coordinates, measured in chunks.
+//              side           - Integer representing the border of interest
+//                               (NORTH, SOUTH, EAST, or WEST).
+//
+//     Outputs: The door's offset along the border, measured in cells.
+//------------------------------------------------------------------------------
+int World::getDoorOffset(int chunkX, int chunkY, int side) const {
+  if (side == SOUTH) {
+    --chunkY;
+    side = NORTH;
+  } else if (side == WEST) {
+    --chunkX;
+    side = EAST;
+  }
+
+  return Random(getChunkSeed(chunkX, chunkY, side)).nextInt(CHUNK_SIZE);
+}
+
+//------------------------------------------------------------------------------
+//      Method: getChunkSeed
+//
+// Description: A private method that derives a seed from the world seed, a
+//              given set of chunk coordinates, and a salt value distinguishing
+//              the purpose of the seed (a border or the chunk's contents).
+//
+//      Inputs: chunkX, chunkY - Chunk coordinates, measured in chunks.
+//              salt           - Purpose of the seed.
+//
+//     Outputs: The derived seed.
+//------------------------------------------------------------------------------
+uint64_t World::getChunkSeed(int chunkX, int chunkY, int salt) const {
+  return seed_ ^ ((uint64_t) (uint32_t) chunkX * 0x9e3779b97f4a7c15ULL) ^
+         ((uint64_t) (uint32_t) chunkY * 0xc2b2ae3d27d4eb4fULL) ^
+         ((uint64_t) salt * 0x165667b19e3779f9ULL);
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************
+   Filename: world.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Declaration of a 'World' class representing an unbounded dungeon
+             made of fixed-size chunks, which are generated on demand around
+             the player and evicted once the player moves far away. Chunks are
+             loaded and evicted by the rendering thread, while their NPCs are
+             moved by the simulation thread; both hold the world's mutex while
+             doing so.
+*******************************************************************************/
+
+#ifndef WORLD_H_
+#define WORLD_H_
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "quest.h"
+
+using namespace std;
+
+class Cell;
+class Quest;
+class Character;
+class MazeMesh;
+class RenderQueue;
+class Frustum;
+struct CrowdInstance;
+
+const int CHUNK_SIZE = 16;  // cells per side
+const int DEFAULT_VIEW_DISTANCE = 2;  // chunks loaded beyond the player's own
+const int NPCS_PER_CHUNK = 2;
+
+// A CHUNK_SIZE x CHUNK_SIZE block of cells (row-major), its baked geometry
+// (built on first draw), and the NPCs spawned with it.
+struct Chunk {
+  int chunkX,
+      chunkY;
+  vector<Cell> cells;
+  MazeMesh *mesh;
+  bool isVisible;  // within the view frustum when last queued
+  vector<Character *> characters;
+};
+
+class World {
+ public:
+  World(Quest *quest, uint64_t seed,
+        int viewDistance = DEFAULT_VIEW_DISTANCE);
+  ~World();
+  int update(double x, double y);
+  int getNumLoadedChunks() const;
+  int getGeneration() const;
+  mutex &getMutex();
+  int getViewDistance() const;
+  const Cell *getCell(int x, int y) const;
+  bool isLegalPosition(double x, double y, double radius) const;
+  int queueMeshes(RenderQueue &queue, const Frustum &frustum, double viewerX,
+                  double viewerY);
+  bool isVisible(double x, double y) const;
+  void act(Character *player);
+  void getCharacters(vector<CrowdInstance> &instances) const;
+ private:
+  Quest *quest_;
+  uint64_t seed_;
+  int viewDistance_;
+  unordered_map<uint64_t, Chunk *> chunks_;
+  int generation_;  // incremented whenever chunks are loaded or evicted
+  mutex mutex_;
+
+  Chunk *generateChunk(int chunkX, int chunkY);
+  void deleteChunk(Chunk *chunk);
+  int getDoorOffset(int chunkX, int chunkY, int side) const;
+  uint64_t getChunkSeed(int chunkX, int chunkY, int salt) const;
+};
+
+#endif  // WORLD_H_